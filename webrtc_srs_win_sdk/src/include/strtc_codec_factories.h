@@ -0,0 +1,29 @@
+#ifndef STRTC_CODEC_FACTORIES_H_
+#define STRTC_CODEC_FACTORIES_H_
+
+#include <functional>
+#include <memory>
+
+#include "api/audio_codecs/audio_decoder_factory.h"
+#include "api/audio_codecs/audio_encoder_factory.h"
+#include "api/scoped_refptr.h"
+#include "api/video_codecs/video_decoder_factory.h"
+#include "api/video_codecs/video_encoder_factory.h"
+
+namespace strtc {
+// Codec factories for StrtcEngineConfig::codecFactories, e.g. a hardware
+// H.264 encoder, a passthrough encoder for pre-encoded content or a decoder
+// that outputs NV12. Each one that is set replaces the builtin factory and
+// is called once, when the engine creates its PeerConnectionFactory.
+//
+// Unlike the other public headers this one needs the libwebrtc headers.
+struct CodecFactories {
+  std::function<std::unique_ptr<webrtc::VideoEncoderFactory>()> videoEncoder;
+  std::function<std::unique_ptr<webrtc::VideoDecoderFactory>()> videoDecoder;
+  std::function<rtc::scoped_refptr<webrtc::AudioEncoderFactory>()>
+      audioEncoder;
+  std::function<rtc::scoped_refptr<webrtc::AudioDecoderFactory>()>
+      audioDecoder;
+};
+}  // namespace strtc
+#endif  // STRTC_CODEC_FACTORIES_H_
@@ -1,38 +1,436 @@
-#ifndef STRTC_COMMON_DEFINE_H_
-#define STRTC_COMMON_DEFINE_H_
-
-#ifdef _WIN32
-#include <windows.h>
-#endif
-
-#include <iostream>
-
-namespace strtc {
-enum StreamType { STRREAM_TYPE_CAMERA, STRREAM_TYPE_SCREEN };
-
-struct StreamOptions {
-  StreamOptions()
-      : streamType(StreamType::STRREAM_TYPE_CAMERA),
-        hasAudio(true),
-        hasVideo(true),
-        width(640),
-        height(480),
-        fps(25) {}
-  StreamType streamType;
-  bool hasAudio;
-  bool hasVideo;
-  int width;
-  int height;
-  int fps;
-};
-
-enum ChannelType { PUBLISH, SUBSCRIBE };
-
-class StrtcEngineObserver {
- public:
-  virtual ~StrtcEngineObserver() = default;
-  virtual void on_stream_error(int channel_id, int code, std::string error) = 0;
-  // virtual void on_add_stream(int channel_id) = 0;
-};
-}  // namespace strtc
-#endif  // STRTC_COMMON_DEFINE_H_
+#ifndef STRTC_COMMON_DEFINE_H_
+#define STRTC_COMMON_DEFINE_H_
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <stdint.h>
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace strtc {
+enum StreamType {
+  STRREAM_TYPE_CAMERA,
+  STRREAM_TYPE_SCREEN,
+  // Generated frames, no camera needed. See StreamOptions::generatorFile.
+  STRREAM_TYPE_GENERATOR,
+  // A single window, see StreamOptions::windowSourceId.
+  STRREAM_TYPE_WINDOW
+};
+
+// Tells the encoder what the video shows, see
+// https://www.w3.org/TR/mst-content-hint/.
+enum ContentHint {
+  CONTENT_HINT_NONE,
+  // Motion, frame rate before resolution.
+  CONTENT_HINT_FLUID,
+  // Slides, documents, resolution before frame rate.
+  CONTENT_HINT_DETAILED,
+  // Text, like detailed with sharper edges.
+  CONTENT_HINT_TEXT
+};
+
+struct StreamOptions {
+  StreamOptions()
+      : streamType(StreamType::STRREAM_TYPE_CAMERA),
+        hasAudio(true),
+        hasVideo(true),
+        width(640),
+        height(480),
+        fps(25),
+        contentHint(CONTENT_HINT_NONE),
+        screenSourceId(-1),
+        windowSourceId(-1) {}
+  StreamType streamType;
+  bool hasAudio;
+  bool hasVideo;
+  int width;
+  int height;
+  int fps;
+  // STRREAM_TYPE_GENERATOR: raw I420 file of width x height frames played
+  // in a loop, empty generates moving squares. A missing file, or one
+  // shorter than a frame, fails the stream start.
+  std::string generatorFile;
+  // CONTENT_HINT_NONE uses CONTENT_HINT_DETAILED for STRREAM_TYPE_SCREEN and
+  // STRREAM_TYPE_WINDOW.
+  ContentHint contentHint;
+  // STRREAM_TYPE_SCREEN: screen to capture, -1 for the full desktop. The
+  // screen is captured at its own size, width and height are ignored.
+  int64_t screenSourceId;
+  // STRREAM_TYPE_WINDOW: CaptureSourceInfo::id of the window to capture, see
+  // getCaptureSources(). Captured at the window's size, which may change.
+  int64_t windowSourceId;
+  // STRREAM_TYPE_CAMERA: VideoDeviceInfo::id of the camera to open. Empty
+  // picks the camera that delivers width x height at fps most cheaply.
+  std::string videoDeviceId;
+};
+
+struct VideoDeviceInfo {
+  VideoDeviceInfo() : modes(0) {}
+  // Stable while the device stays plugged in, see
+  // StreamOptions::videoDeviceId.
+  std::string id;
+  std::string name;
+  // Capture modes the device reports.
+  int modes;
+};
+
+// The camera mode a STRREAM_TYPE_CAMERA stream was opened with, and what it
+// costs to turn it into the requested frames.
+struct CaptureFormatInfo {
+  CaptureFormatInfo()
+      : width(0), height(0), fps(0), scaled(false), degraded(false) {}
+  std::string videoDeviceId;
+  // Native pixel format of the mode, e.g. "MJPEG", "YUY2", "I420".
+  std::string videoType;
+  int width;
+  int height;
+  int fps;
+  // "copy", "repack", "convert" or "decode" to I420.
+  std::string conversion;
+  // Larger than requested, scaled down after conversion.
+  bool scaled;
+  // Smaller or slower than requested, no mode delivers the request.
+  bool degraded;
+  // "MJPEG 1280x720@30 -> I420 (decode) -> 640x360@25"
+  std::string path;
+};
+
+// A screen or window that can be captured.
+struct CaptureSourceInfo {
+  CaptureSourceInfo() : id(-1) {}
+  int64_t id;
+  // UTF-8, may be empty.
+  std::string title;
+};
+
+enum ChannelType { PUBLISH, SUBSCRIBE };
+
+struct IceServer {
+  IceServer() {}
+  explicit IceServer(const std::string& url) : urls(1, url) {}
+  // "stun:host:port", "turn:host:port?transport=udp", "turns:host:port"
+  std::vector<std::string> urls;
+  std::string username;
+  std::string password;
+};
+
+struct IceOptions {
+  IceOptions()
+      : servers(1, IceServer("stun:stun.l.google.com:19302")),
+        tcpCandidates(true),
+        candidatePoolSize(0),
+        continualGathering(false),
+        hostOnly(false) {}
+  std::vector<IceServer> servers;
+  // Gather TCP host candidates as well.
+  bool tcpCandidates;
+  // Candidates gathered before the offer is created.
+  int candidatePoolSize;
+  // Keep gathering on network changes instead of stopping after the first
+  // pass.
+  bool continualGathering;
+  // Host candidates only, servers are ignored. For SRS deployments that put
+  // reachable candidates in the answer, gathering then never waits on a
+  // STUN/TURN server.
+  bool hostOnly;
+};
+
+// One simulcast encoding of a PUBLISH channel.
+struct SimulcastLayer {
+  SimulcastLayer() : scaleDownBy(1), maxBitrateKbps(0), maxFramerate(0) {}
+  SimulcastLayer(const std::string& rid, double scaleDownBy,
+                 int maxBitrateKbps, int maxFramerate = 0)
+      : rid(rid),
+        scaleDownBy(scaleDownBy),
+        maxBitrateKbps(maxBitrateKbps),
+        maxFramerate(maxFramerate) {}
+  // RTP stream id, e.g. "h", "m", "l".
+  std::string rid;
+  // Resolution divisor against the captured video, 1 is full size.
+  double scaleDownBy;
+  // 0 leaves the limit to the encoder.
+  int maxBitrateKbps;
+  int maxFramerate;
+};
+
+struct ChannelOptions {
+  ChannelOptions() : measureLatency(false) {}
+  IceOptions ice;
+  // Video codec names in order of preference, e.g. {"H264", "VP8"}. Codecs
+  // not listed follow in their default order. SRS bridges H.264 to RTMP
+  // without transcoding.
+  std::vector<std::string> videoCodecs;
+  // PUBLISH: 2-3 layers encode the video at several sizes in one encoder
+  // pass, for viewers on different links. Empty sends a single encoding.
+  // The server has to accept the rids in its answer, otherwise only the
+  // first layer is sent.
+  std::vector<SimulcastLayer> simulcast;
+  // Glass-to-glass latency probe. A PUBLISH channel stamps the capture
+  // wall clock time into every H.264 or VP8 video frame, a SUBSCRIBE channel
+  // reads it and reports capture -> render latency through
+  // StrtcEngineObserver::on_glass_to_glass_latency. Both ends need it, on
+  // one host or on hosts with synchronized clocks. Viewers without the
+  // probe decode the stamped frames as usual.
+  bool measureLatency;
+};
+
+// What the encoder gives up first when CPU or bandwidth run short.
+enum DegradationPreference {
+  // Keep the current preference.
+  DEGRADATION_UNCHANGED,
+  // Lower the resolution, keep the frame rate.
+  DEGRADATION_MAINTAIN_FRAMERATE,
+  // Drop frames, keep the resolution.
+  DEGRADATION_MAINTAIN_RESOLUTION,
+  DEGRADATION_BALANCED,
+  // Neither, the encoder overshoots instead.
+  DEGRADATION_DISABLED
+};
+
+// Live changes to a PUBLISH channel's video encodings. -1 (0 for
+// scaleDownBy) keeps a value, 0 removes a bitrate or frame rate limit.
+// Bitrates above INT_MAX / 1000 kbps are rejected.
+struct EncoderParameters {
+  EncoderParameters()
+      : maxBitrateKbps(-1),
+        minBitrateKbps(-1),
+        maxFramerate(-1),
+        scaleDownBy(0),
+        degradation(DEGRADATION_UNCHANGED) {}
+  // ChannelOptions::simulcast layer to change, empty changes every
+  // encoding.
+  std::string rid;
+  int maxBitrateKbps;
+  int minBitrateKbps;
+  int maxFramerate;
+  // Resolution divisor against the captured video, at least 1.
+  double scaleDownBy;
+  // Applies to the whole sender, not per rid.
+  DegradationPreference degradation;
+};
+
+// Why the encoder currently sends less than it was configured for, from
+// the quality limitation reason of the stats.
+enum EncoderLimitation {
+  ENCODER_LIMITATION_NONE,
+  ENCODER_LIMITATION_CPU,
+  ENCODER_LIMITATION_BANDWIDTH,
+  ENCODER_LIMITATION_OTHER
+};
+
+enum ThreadPriority {
+  THREAD_PRIO_LOW,
+  THREAD_PRIO_NORMAL,
+  THREAD_PRIO_HIGH,
+  THREAD_PRIO_REALTIME
+};
+
+struct ThreadOptions {
+  ThreadOptions() : priority(THREAD_PRIO_NORMAL), affinityMask(0) {}
+  explicit ThreadOptions(const std::string& name)
+      : name(name), priority(THREAD_PRIO_NORMAL), affinityMask(0) {}
+  std::string name;
+  ThreadPriority priority;
+  // Bit n allows cpu n, 0 leaves the thread on every cpu.
+  uint64_t affinityMask;
+};
+
+struct ThreadGroupConfig {
+  ThreadGroupConfig()
+      : network("strtc_network"),
+        worker("strtc_worker"),
+        signaling("strtc_signaling") {}
+  // Packet I/O.
+  ThreadOptions network;
+  // Encode/decode, audio device and media engine.
+  ThreadOptions worker;
+  // PeerConnection api and observer callbacks.
+  ThreadOptions signaling;
+};
+
+struct ThreadLoad {
+  ThreadLoad() : cpuUsage(0), queueDelayMs(0) {}
+  std::string name;
+  // Percent of one core used since the previous sample.
+  double cpuUsage;
+  // How late a task posted to the thread ran at the last sample.
+  int64_t queueDelayMs;
+};
+
+class StrtcThreadGroup;
+struct CodecFactories;
+
+struct StrtcEngineConfig {
+  StrtcEngineConfig()
+      : maxConcurrentStarts(32),
+        perHostStartIntervalMs(0),
+        startTimeoutMs(15000),
+        subscribePoolSize(0),
+        statsIntervalMs(0) {}
+  // Threads shared with other engines, see StrtcThreadGroup::create. When
+  // empty the engine creates its own group from threadConfig.
+  std::shared_ptr<StrtcThreadGroup> threads;
+  ThreadGroupConfig threadConfig;
+  // Channels in createPeerConnection -> offer -> answer at the same time,
+  // further starts wait in a queue. 0 means unlimited.
+  int maxConcurrentStarts;
+  // Minimum gap between two channel starts against the same SRS host.
+  int perHostStartIntervalMs;
+  // A start that has not succeeded or failed after this long gives its slot
+  // to the next queued channel. 0 means never.
+  int startTimeoutMs;
+  // Recv-only PeerConnections kept ready, with transceivers added and ICE
+  // pre-gathered, for SUBSCRIBE channels. 0 disables the pool.
+  int subscribePoolSize;
+  // Used by createChannel(type) and the subscribe pool.
+  IceOptions ice;
+  std::vector<std::string> videoCodecs;
+  // Replaces the builtin codec factories, see strtc_codec_factories.h.
+  std::shared_ptr<CodecFactories> codecFactories;
+  // Every channel's RTC stats are pulled at this interval and reported
+  // through StrtcEngineObserver::on_channel_stats. 0 disables the
+  // collector.
+  int statsIntervalMs;
+};
+
+// How long each step of a channel start took, in milliseconds.
+struct ChannelSetupTimings {
+  ChannelSetupTimings()
+      : queueMs(0),
+        createOfferMs(0),
+        signalingMs(0),
+        setRemoteMs(0),
+        totalMs(0) {}
+  int64_t queueMs;        // waiting for a free scheduler slot
+  int64_t createOfferMs;  // createPeerConnection + CreateOffer
+  int64_t signalingMs;    // offer/answer round trip to the server
+  int64_t setRemoteMs;    // SetRemoteDescription
+  int64_t totalMs;        // start() to success
+};
+
+// Engine calls whose cost is tracked by getApiLatency().
+enum ApiCall {
+  API_START_STREAM,
+  API_STOP_STREAM,
+  API_CREATE_CHANNEL,
+  // stop(channel_id) until the PeerConnection is closed and released.
+  API_STOP_CHANNEL
+};
+
+struct LatencySummary {
+  LatencySummary()
+      : count(0), avgMs(0), p50Ms(0), p90Ms(0), p99Ms(0), maxMs(0) {}
+  int64_t count;
+  double avgMs;
+  int64_t p50Ms;
+  int64_t p90Ms;
+  int64_t p99Ms;
+  int64_t maxMs;
+};
+
+struct VideoTileStats {
+  VideoTileStats() : tile(0), received(0), capped(0), dropped(0), rendered(0) {}
+  int tile;
+  int64_t received;
+  // Dropped on arrival by the tile frame rate cap.
+  int64_t capped;
+  // Replaced by a newer frame before the compositor got to them.
+  int64_t dropped;
+  int64_t rendered;
+};
+
+// One simulcast layer of a PUBLISH channel.
+struct LayerStats {
+  LayerStats()
+      : bitrateKbps(0), framesPerSecond(0), frameWidth(0), frameHeight(0) {}
+  std::string rid;
+  int64_t bitrateKbps;
+  double framesPerSecond;
+  int frameWidth;
+  int frameHeight;
+  std::string qualityLimitationReason;
+};
+
+// One channel's RTC stats, reduced from its RTCStatsReport. Rates and
+// averages cover the time since the previous sample, counts are totals.
+struct ChannelStats {
+  ChannelStats()
+      : channelId(0),
+        type(PUBLISH),
+        timestampMs(0),
+        bitrateKbps(0),
+        framesPerSecond(0),
+        frameWidth(0),
+        frameHeight(0),
+        jitterBufferDelayMs(0),
+        freezeCount(0),
+        freezeDurationMs(0),
+        packetsLost(0),
+        packetLossPercent(0),
+        rttMs(0),
+        encodeTimeMs(0),
+        decodeTimeMs(0) {}
+  int channelId;
+  ChannelType type;
+  int64_t timestampMs;
+  // Sent by PUBLISH, received by SUBSCRIBE channels, audio and video.
+  int64_t bitrateKbps;
+  // Video, encoded or decoded.
+  double framesPerSecond;
+  int frameWidth;
+  int frameHeight;
+  // SUBSCRIBE: average time a video frame waited in the jitter buffer.
+  double jitterBufferDelayMs;
+  // SUBSCRIBE: video freezes and their total duration.
+  int64_t freezeCount;
+  double freezeDurationMs;
+  // Lost by the network, reported by the remote side for PUBLISH.
+  int64_t packetsLost;
+  double packetLossPercent;
+  double rttMs;
+  // PUBLISH: "none", "cpu", "bandwidth" or "other".
+  std::string qualityLimitationReason;
+  // Average per video frame.
+  double encodeTimeMs;
+  double decodeTimeMs;
+  // PUBLISH with ChannelOptions::simulcast, one entry per sent layer.
+  std::vector<LayerStats> layers;
+};
+
+enum StatsFormat {
+  // Prometheus text exposition format, one gauge per ChannelStats field.
+  STATS_FORMAT_PROMETHEUS,
+  // {"channels":[{...}, ...]}
+  STATS_FORMAT_JSON
+};
+
+class StrtcEngineObserver {
+ public:
+  virtual ~StrtcEngineObserver() = default;
+  virtual void on_stream_error(int channel_id, int code, std::string error) = 0;
+  virtual void on_channel_setup(int channel_id,
+                                const ChannelSetupTimings& timings) {}
+  virtual void on_channel_stopped(int channel_id, int64_t teardown_ms) {}
+  // A camera was plugged in or removed, `devices` is the new list.
+  virtual void on_video_devices_changed(
+      const std::vector<VideoDeviceInfo>& devices) {}
+  // Every StrtcEngineConfig::statsIntervalMs for each started channel.
+  virtual void on_channel_stats(const ChannelStats& stats) {}
+  // ChannelOptions::measureLatency: capture -> render latency of the video
+  // frames a SUBSCRIBE channel rendered in the last few seconds.
+  virtual void on_glass_to_glass_latency(int channel_id,
+                                         const LatencySummary& latency) {}
+  // A PUBLISH channel's encoder became CPU or bandwidth limited, or no
+  // longer is. Detected from the stats, so it needs
+  // StrtcEngineConfig::statsIntervalMs.
+  virtual void on_encoder_limitation_changed(int channel_id,
+                                             EncoderLimitation limitation) {}
+  // virtual void on_add_stream(int channel_id) = 0;
+};
+}  // namespace strtc
+#endif  // STRTC_COMMON_DEFINE_H_
@@ -5,6 +5,8 @@
 #include <iostream>
 
 #include "strtc_common_define.h"
+#include "strtc_thread_group.h"
+#include "strtc_video_sink.h"
 
 namespace strtc {
 class StrtcEngineInterface {
@@ -14,17 +16,84 @@ class StrtcEngineInterface {
   static StrtcEngineInterface* create(StrtcEngineObserver* observer);
 
   virtual bool init() = 0;
+  virtual bool init(const StrtcEngineConfig& config) = 0;
+  // The synchronous calls block until the engine thread ran them, the
+  // *Async variants return at once and report completion on the engine
+  // thread.
   virtual bool startStream(StreamOptions& options) = 0;
+  virtual void startStreamAsync(const StreamOptions& options,
+                                std::function<void(bool success)> on_done) = 0;
   virtual void stopStream() = 0;
+  virtual void stopStreamAsync(std::function<void()> on_done) = 0;
   virtual void setLocalVideoRender(HWND wnd) = 0;
   virtual void setRemoteVideoRender(int channel_id, HWND wnd) = 0;
+  // Video wall: remote channels drawn into a rows x columns grid of one
+  // window, which is painted once per display refresh instead of once per
+  // channel frame. Tiles are capped to maxTileFps, 0 means no cap. Calling
+  // it again rebuilds the wall and empties every tile.
+  virtual void setVideoWall(HWND wnd, int rows, int columns,
+                            int maxTileFps) = 0;
+  // Shows the channel in tile `tile`, counted row by row from the top left.
+  // -1 takes the channel off the wall.
+  virtual void setRemoteVideoTile(int channel_id, int tile) = 0;
+  // Any thread, never waits for the engine thread.
+  virtual std::vector<VideoTileStats> getVideoWallStats() = 0;
+  // Window-less alternatives to setLocalVideoRender/setRemoteVideoRender,
+  // see strtc_video_sink.h. nullptr detaches the current sink.
+  virtual void setLocalVideoSink(std::shared_ptr<StrtcVideoSink> sink) = 0;
+  virtual void setRemoteVideoSink(int channel_id,
+                                  std::shared_ptr<StrtcVideoSink> sink) = 0;
   virtual void muteLocalAudio(bool mute) = 0;
   virtual void muteLocalVideo(bool mute) = 0;
   virtual int createChannel(ChannelType type) = 0;
+  virtual void createChannelAsync(
+      ChannelType type, std::function<void(int channel_id)> on_done) = 0;
+  // Channel with its own options instead of the StrtcEngineConfig ones.
+  // Never uses a pooled PeerConnection.
+  virtual int createChannel(ChannelType type,
+                            const ChannelOptions& options) = 0;
+  virtual void createChannelAsync(
+      ChannelType type, const ChannelOptions& options,
+      std::function<void(int channel_id)> on_done) = 0;
   virtual void start(int channel_id, const std::string& url,
                      std::function<void()> on_success,
                      std::function<void(std::string error)> on_failure) = 0;
+  // Pauses or resumes one ChannelOptions::simulcast layer of a PUBLISH
+  // channel without renegotiation.
+  virtual void setSimulcastLayerActive(int channel_id, const std::string& rid,
+                                       bool active) = 0;
+  // Changes bitrate limits, frame rate, scale-down and degradation
+  // preference of a PUBLISH channel without renegotiation. `on_done` runs on
+  // the engine thread, false for an unknown channel or rid, a bitrate out of
+  // range or parameters the sender refused.
+  virtual void setEncoderParameters(
+      int channel_id, const EncoderParameters& parameters,
+      std::function<void(bool success)> on_done) = 0;
+  // Tears the channel down: the server session is released, the
+  // PeerConnection closed and the channel id becomes invalid.
   virtual void stop(int channel_id) = 0;
+
+  // Time from each call until the engine thread finished it, i.e. how long
+  // the synchronous variant blocks or would have blocked.
+  virtual LatencySummary getApiLatency(ApiCall call) = 0;
+  // Load of the network, worker and signaling threads used by this engine.
+  virtual std::vector<ThreadLoad> getThreadLoad() = 0;
+  // Cameras, cached and kept current on plug/unplug, see
+  // StrtcEngineObserver::on_video_devices_changed.
+  virtual std::vector<VideoDeviceInfo> getVideoDevices() = 0;
+  // Mode and conversion path of the camera opened by startStream(), false
+  // without a started camera stream. Any thread, never waits for the
+  // engine thread.
+  virtual bool getCaptureFormat(CaptureFormatInfo* info) = 0;
+  // Screens for STRREAM_TYPE_SCREEN or windows for STRREAM_TYPE_WINDOW,
+  // empty for any other type.
+  virtual std::vector<CaptureSourceInfo> getCaptureSources(
+      StreamType type) = 0;
+  // Latest stats of every channel, empty unless
+  // StrtcEngineConfig::statsIntervalMs is set.
+  virtual std::vector<ChannelStats> getChannelStats() = 0;
+  // The same as text, for a metrics endpoint or a log line.
+  virtual std::string getStatsSnapshot(StatsFormat format) = 0;
 };
 }  // namespace strtc
 #endif  // STRTC_ENGINE_INTERFACE_H_
\ No newline at end of file
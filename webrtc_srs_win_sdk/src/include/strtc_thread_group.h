@@ -0,0 +1,26 @@
+#ifndef STRTC_THREAD_GROUP_H_
+#define STRTC_THREAD_GROUP_H_
+
+#include <memory>
+#include <vector>
+
+#include "strtc_common_define.h"
+
+namespace strtc {
+// The network, worker and signaling threads of a PeerConnectionFactory.
+// One group can be passed to several engines through StrtcEngineConfig so
+// they share the same threads.
+// Only groups returned by create() are accepted, StrtcEngine::init fails
+// for any other implementation.
+class StrtcThreadGroup {
+ public:
+  static std::shared_ptr<StrtcThreadGroup> create(
+      const ThreadGroupConfig& config);
+
+  virtual ~StrtcThreadGroup() = default;
+
+  // Sampled about once per second on each thread.
+  virtual std::vector<ThreadLoad> getLoad() = 0;
+};
+}  // namespace strtc
+#endif  // STRTC_THREAD_GROUP_H_
@@ -0,0 +1,104 @@
+#ifndef STRTC_VIDEO_SINK_H_
+#define STRTC_VIDEO_SINK_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "strtc_common_define.h"
+
+namespace strtc {
+// An I420 frame, the planes are only valid during onFrame().
+struct VideoFrameData {
+  VideoFrameData()
+      : width(0),
+        height(0),
+        rotation(0),
+        dataY(nullptr),
+        dataU(nullptr),
+        dataV(nullptr),
+        strideY(0),
+        strideU(0),
+        strideV(0),
+        timestampUs(0),
+        rtpTimestamp(0),
+        ntpTimeMs(0) {}
+  int width;
+  int height;
+  // Clockwise degrees the frame has to be rotated by for display.
+  int rotation;
+  const uint8_t* dataY;
+  const uint8_t* dataU;
+  const uint8_t* dataV;
+  int strideY;
+  int strideU;
+  int strideV;
+  // Local clock: capture time of local frames, render time of remote ones.
+  int64_t timestampUs;
+  uint32_t rtpTimestamp;
+  // Sender capture time, 0 when unknown.
+  int64_t ntpTimeMs;
+};
+
+struct VideoSinkStats {
+  VideoSinkStats() : frames(0), dropped(0) {}
+  int64_t frames;
+  // Frames the sink could not keep, e.g. a full file writer queue.
+  int64_t dropped;
+  // Delivery time minus timestampUs.
+  LatencySummary latency;
+};
+
+struct VideoFrameHash {
+  VideoFrameHash()
+      : timestampUs(0), rtpTimestamp(0), width(0), height(0), hash(0) {}
+  int64_t timestampUs;
+  uint32_t rtpTimestamp;
+  int width;
+  int height;
+  // 64 bit FNV-1a over the visible Y, U and V pixels.
+  uint64_t hash;
+};
+
+enum VideoFileFormat { VIDEO_FILE_I420, VIDEO_FILE_Y4M };
+
+// Receives decoded or captured frames without a window, see
+// StrtcEngineInterface::setRemoteVideoSink/setLocalVideoSink.
+class StrtcVideoSink {
+ public:
+  virtual ~StrtcVideoSink() = default;
+
+  // Called on the decoder or capturer thread, must return quickly.
+  virtual void onFrame(const VideoFrameData& frame) = 0;
+  virtual VideoSinkStats getStats() = 0;
+};
+
+// Writes raw frames to `path` on a background thread. At most
+// `maxQueuedFrames` wait for the disk, further frames are dropped. Y4M
+// files keep the first frame size, frames of another size are dropped.
+class StrtcFileVideoSink : public StrtcVideoSink {
+ public:
+  static std::shared_ptr<StrtcFileVideoSink> create(const std::string& path,
+                                                    VideoFileFormat format,
+                                                    int maxQueuedFrames = 30);
+};
+
+// Hashes every frame, for comparing what was sent with what arrived.
+class StrtcHashVideoSink : public StrtcVideoSink {
+ public:
+  static std::shared_ptr<StrtcHashVideoSink> create();
+
+  // Hashes since the previous call, oldest first. Keeps at most the last
+  // 10000.
+  virtual std::vector<VideoFrameHash> takeHashes() = 0;
+};
+
+// Only counts frames and their latency.
+class StrtcNullVideoSink : public StrtcVideoSink {
+ public:
+  static std::shared_ptr<StrtcNullVideoSink> create();
+};
+}  // namespace strtc
+#endif  // STRTC_VIDEO_SINK_H_
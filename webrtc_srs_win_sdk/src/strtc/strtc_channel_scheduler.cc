@@ -0,0 +1,119 @@
+#include "strtc_channel_scheduler.h"
+
+#include "rtc_base/logging.h"
+#include "rtc_base/task_utils/to_queued_task.h"
+#include "rtc_base/time_utils.h"
+
+namespace strtc {
+StrtcChannelScheduler::StrtcChannelScheduler(rtc::Thread* thread,
+                                             int max_concurrent,
+                                             int per_host_interval_ms,
+                                             int start_timeout_ms)
+    : thread_(thread),
+      max_concurrent_(max_concurrent),
+      per_host_interval_ms_(per_host_interval_ms),
+      start_timeout_ms_(start_timeout_ms) {}
+
+StrtcChannelScheduler::~StrtcChannelScheduler() = default;
+
+void StrtcChannelScheduler::schedule(int channel_id, const std::string& url,
+                                     StartTask task) {
+  RTC_DCHECK(thread_->IsCurrent());
+  queue_.push_back({channel_id, hostOf(url), std::move(task)});
+  pump();
+}
+
+void StrtcChannelScheduler::cancel(int channel_id) {
+  RTC_DCHECK(thread_->IsCurrent());
+  for (auto it = queue_.begin(); it != queue_.end(); ++it) {
+    if (it->channel_id == channel_id) {
+      queue_.erase(it);
+      return;
+    }
+  }
+  if (running_.erase(channel_id)) {
+    pump();
+  }
+}
+
+// "webrtc://172.16.28.35:1985/live/livestream" -> "172.16.28.35:1985"
+std::string StrtcChannelScheduler::hostOf(const std::string& url) {
+  size_t host_begin = url.find("://");
+  host_begin = host_begin == std::string::npos ? 0 : host_begin + 3;
+  size_t host_end = url.find_first_of("/?#", host_begin);
+  return url.substr(host_begin, host_end == std::string::npos
+                                    ? std::string::npos
+                                    : host_end - host_begin);
+}
+
+void StrtcChannelScheduler::done(int channel_id, uint64_t sequence) {
+  RTC_DCHECK(thread_->IsCurrent());
+  auto it = running_.find(channel_id);
+  if (it == running_.end() || it->second != sequence) {
+    return;
+  }
+  running_.erase(it);
+  pump();
+}
+
+void StrtcChannelScheduler::pump() {
+  int64_t now_ms = rtc::TimeMillis();
+  int64_t next_start_ms = -1;
+
+  for (auto it = queue_.begin(); it != queue_.end();) {
+    if (max_concurrent_ > 0 &&
+        static_cast<int>(running_.size()) >= max_concurrent_) {
+      return;
+    }
+
+    if (per_host_interval_ms_ > 0) {
+      auto last = last_start_ms_.find(it->host);
+      if (last != last_start_ms_.end() &&
+          now_ms - last->second < per_host_interval_ms_) {
+        int64_t start_ms = last->second + per_host_interval_ms_;
+        if (next_start_ms < 0 || start_ms < next_start_ms) {
+          next_start_ms = start_ms;
+        }
+        ++it;
+        continue;
+      }
+      last_start_ms_[it->host] = now_ms;
+    }
+
+    PendingStart start = std::move(*it);
+    it = queue_.erase(it);
+    int channel_id = start.channel_id;
+    uint64_t sequence = ++next_sequence_;
+    running_[channel_id] = sequence;
+
+    if (start_timeout_ms_ > 0) {
+      thread_->PostDelayedTask(
+          webrtc::ToQueuedTask([this, channel_id, sequence]() {
+            auto it = running_.find(channel_id);
+            if (it != running_.end() && it->second == sequence) {
+              RTC_LOG(LS_WARNING) << "channel id: " << channel_id
+                                  << " start timed out, slot released";
+              done(channel_id, sequence);
+            }
+          }),
+          static_cast<uint32_t>(start_timeout_ms_));
+    }
+
+    rtc::Thread* thread = thread_;
+    start.task([this, thread, channel_id, sequence]() {
+      thread->PostTask(webrtc::ToQueuedTask(
+          [this, channel_id, sequence]() { done(channel_id, sequence); }));
+    });
+  }
+
+  // Everything left is waiting for its host interval.
+  if (next_start_ms >= 0 && !delayed_pump_) {
+    delayed_pump_ = true;
+    thread_->PostDelayedTask(webrtc::ToQueuedTask([this]() {
+                               delayed_pump_ = false;
+                               pump();
+                             }),
+                             static_cast<uint32_t>(next_start_ms - now_ms));
+  }
+}
+}  // namespace strtc
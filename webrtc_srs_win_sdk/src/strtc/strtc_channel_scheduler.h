@@ -0,0 +1,58 @@
+#ifndef STRTC_CHANNEL_SCHEDULER_H_
+#define STRTC_CHANNEL_SCHEDULER_H_
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+
+#include "rtc_base/thread.h"
+
+namespace strtc {
+// Bounds how many channels go through createPeerConnection -> offer -> answer
+// at once and spaces out starts against the same host. All methods must be
+// called on `thread`.
+class StrtcChannelScheduler {
+ public:
+  // Receives a callback that must be invoked, from any thread, once the
+  // channel start finished or failed.
+  using StartTask = std::function<void(std::function<void()> done)>;
+
+  // A running start that has not called `done` within `start_timeout_ms`
+  // loses its slot, 0 disables the timeout.
+  StrtcChannelScheduler(rtc::Thread* thread, int max_concurrent,
+                        int per_host_interval_ms, int start_timeout_ms);
+  ~StrtcChannelScheduler();
+
+  void schedule(int channel_id, const std::string& url, StartTask task);
+  // Drops a queued start or frees the slot of a running one.
+  void cancel(int channel_id);
+
+ private:
+  struct PendingStart {
+    int channel_id;
+    std::string host;
+    StartTask task;
+  };
+
+  static std::string hostOf(const std::string& url);
+  // Frees the slot of `channel_id` if it still belongs to start `sequence`,
+  // a late callback of an earlier start must not free a newer one.
+  void done(int channel_id, uint64_t sequence);
+  void pump();
+
+ private:
+  rtc::Thread* thread_;
+  int max_concurrent_;
+  int per_host_interval_ms_;
+  int start_timeout_ms_;
+
+  std::deque<PendingStart> queue_;
+  // channel id -> sequence of its running start.
+  std::map<int, uint64_t> running_;
+  uint64_t next_sequence_ = 0;
+  std::map<std::string, int64_t> last_start_ms_;
+  bool delayed_pump_ = false;
+};
+}  // namespace strtc
+#endif  // STRTC_CHANNEL_SCHEDULER_H_
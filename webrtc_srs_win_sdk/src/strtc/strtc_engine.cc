@@ -1,5 +1,9 @@
 #include "strtc_engine.h"
 
+#include "strtc_codec_factories.h"
+#include "strtc_screen_capturer.h"
+#include "strtc_vcm_capturer.h"
+
 #include "api/audio_codecs/audio_decoder_factory.h"
 #include "api/audio_codecs/audio_encoder_factory.h"
 #include "api/audio_codecs/builtin_audio_decoder_factory.h"
@@ -13,16 +17,57 @@
 #include "modules/audio_device/include/audio_device.h"
 #include "modules/video_capture/video_capture_factory.h"
 #include "pc/video_track_source.h"
+#include "rtc_base/event.h"
 #include "rtc_base/ssl_adapter.h"
+#include "rtc_base/time_utils.h"
 #include "rtc_base/trace_event.h"
 
 namespace strtc {
+// Video wall canvas when the window has no client area yet.
+constexpr int kDefaultVideoWallWidth = 1280;
+constexpr int kDefaultVideoWallHeight = 720;
+
+static std::vector<VideoDeviceInfo> toVideoDeviceInfos(
+    const std::vector<VideoDevice>& devices) {
+  std::vector<VideoDeviceInfo> infos;
+  for (const auto& device : devices) {
+    VideoDeviceInfo info;
+    info.id = device.id;
+    info.name = device.name;
+    info.modes = static_cast<int>(device.capabilities.size());
+    infos.push_back(info);
+  }
+  return infos;
+}
+
 StrtcEngine::StrtcEngine(StrtcEngineObserver* observer)
     : channel_id_(0), observer_(observer) {}
 
-StrtcEngine::~StrtcEngine() { rtc::CleanupSSL(); }
+StrtcEngine::~StrtcEngine() {
+  if (device_listener_ >= 0) {
+    VideoDeviceRegistry::Instance()->RemoveListener(device_listener_);
+  }
+  // Aborts pending signaling requests, their failures are posted to the
+  // signaling thread and flushed below.
+  if (http_loop_) {
+    http_loop_->Stop();
+  }
+  // Queued tasks touch the channels and the scheduler, drop them as well.
+  if (task_thread_) {
+    task_thread_->Stop();
+  }
+  // Channel teardowns still queued on the signaling thread report back to
+  // this engine, and the thread may be shared with other engines.
+  if (threads_) {
+    threads_->signaling()->Invoke<void>(RTC_FROM_HERE, []() {});
+  }
+  rtc::CleanupSSL();
+}
+
+bool StrtcEngine::init() { return init(StrtcEngineConfig()); }
 
-bool StrtcEngine::init() {
+bool StrtcEngine::init(const StrtcEngineConfig& config) {
+  config_ = config;
   rtc::LogMessage::LogToDebug(rtc::LoggingSeverity::LS_VERBOSE);
 
   rtc::InitializeSSL();
@@ -32,66 +77,243 @@ bool StrtcEngine::init() {
     return false;
   }
 
+  http_loop_.reset(new HttpRequestLoop());
+  if (!http_loop_->Start()) {
+    return false;
+  }
+
+  // Starts the camera enumeration now, startStream() then finds it cached.
+  device_listener_ = VideoDeviceRegistry::Instance()->AddListener(
+      [this](const std::vector<VideoDevice>& devices) {
+        std::vector<VideoDeviceInfo> infos = toVideoDeviceInfos(devices);
+        task_thread_->PostTask(webrtc::ToQueuedTask([this, infos]() {
+          if (observer_) {
+            observer_->on_video_devices_changed(infos);
+          }
+        }));
+      });
+
+  scheduler_.reset(new StrtcChannelScheduler(task_thread_.get(),
+                                             config_.maxConcurrentStarts,
+                                             config_.perHostStartIntervalMs,
+                                             config_.startTimeoutMs));
+
   if (!createPeerConnectionFactory()) {
     return false;
   }
 
+  if (config_.statsIntervalMs > 0) {
+    stats_collector_.reset(new StrtcStatsCollector(
+        task_thread_.get(), config_.statsIntervalMs,
+        [this](const ChannelStats& stats) { onChannelStats(stats); }));
+  }
+
+  if (config_.subscribePoolSize > 0) {
+    subscribe_pool_.reset(new StrtcPeerConnectionPool(
+        task_thread_.get(), factory_, config_.ice, config_.subscribePoolSize));
+    task_thread_->PostTask(
+        webrtc::ToQueuedTask([this]() { subscribe_pool_->fill(); }));
+  }
+
   return true;
 }
 
 bool StrtcEngine::startStream(StreamOptions& options) {
-  if (!task_thread_->IsCurrent()) {
-    return task_thread_->Invoke<bool>(
-        RTC_FROM_HERE, [this, &options]() { return startStream(options); });
+  if (task_thread_->IsCurrent()) {
+    return doStartStream(options);
   }
+  bool result = false;
+  rtc::Event done;
+  startStreamAsync(options, [&result, &done](bool success) {
+    result = success;
+    done.Set();
+  });
+  done.Wait(rtc::Event::kForever);
+  return result;
+}
+
+void StrtcEngine::startStreamAsync(const StreamOptions& options,
+                                   std::function<void(bool success)> on_done) {
+  int64_t call_ms = rtc::TimeMillis();
+  task_thread_->PostTask(
+      webrtc::ToQueuedTask([this, options, on_done, call_ms]() {
+        bool success = doStartStream(options);
+        api_latency_[API_START_STREAM].add(rtc::TimeMillis() - call_ms);
+        if (on_done) {
+          on_done(success);
+        }
+      }));
+}
+
+bool StrtcEngine::doStartStream(StreamOptions options) {
+  setCaptureFormat(nullptr);
   local_stream_.reset(new StrtcMediaStream(factory_, options));
   if (local_stream_) {
-    return local_stream_->startStream();
+    if (!local_stream_->startStream()) {
+      return false;
+    }
+    if (local_sink_) {
+      local_stream_->addVideoSink(local_sink_.get());
+    }
+    CaptureFormat format;
+    if (local_stream_->getCaptureFormat(&format)) {
+      setCaptureFormat(&format);
+    }
+    return true;
   }
 
   return false;
 }
 
 void StrtcEngine::stopStream() {
-  if (!task_thread_->IsCurrent()) {
-    return task_thread_->Invoke<void>(RTC_FROM_HERE,
-                                      [this]() { return stopStream(); });
+  if (task_thread_->IsCurrent()) {
+    return doStopStream();
   }
+  rtc::Event done;
+  stopStreamAsync([&done]() { done.Set(); });
+  done.Wait(rtc::Event::kForever);
+}
+
+void StrtcEngine::stopStreamAsync(std::function<void()> on_done) {
+  int64_t call_ms = rtc::TimeMillis();
+  task_thread_->PostTask(webrtc::ToQueuedTask([this, on_done, call_ms]() {
+    doStopStream();
+    api_latency_[API_STOP_STREAM].add(rtc::TimeMillis() - call_ms);
+    if (on_done) {
+      on_done();
+    }
+  }));
+}
+
+void StrtcEngine::doStopStream() {
   // ֹͣɼֹͣ
   for (auto it = channel_map_.begin(); it != channel_map_.end();) {
     if (it->second->getChannelType() == ChannelType::PUBLISH) {
-      channel_map_.erase(it++);
+      doStopChannel((it++)->first, rtc::TimeMillis());
     } else {
       ++it;
     }
   }
+  setCaptureFormat(nullptr);
   local_stream_.reset();
 }
 
+void StrtcEngine::setCaptureFormat(const CaptureFormat* format) {
+  std::lock_guard<std::mutex> lock(capture_format_mutex_);
+  if (!format) {
+    capture_format_.reset();
+    return;
+  }
+  CaptureFormatInfo info;
+  info.videoDeviceId = format->device_id;
+  info.videoType = format->video_type;
+  info.width = format->capability.width;
+  info.height = format->capability.height;
+  info.fps = format->capability.maxFPS;
+  info.conversion = format->conversion();
+  info.scaled = format->scaled;
+  info.degraded = format->degraded;
+  info.path = format->path;
+  capture_format_ = info;
+}
+
 bool StrtcEngine::createPeerConnectionFactory() {
-  if (!signaling_thread_.get()) {
-    signaling_thread_ = rtc::Thread::Create();
-    if (!signaling_thread_->Start()) {
+  if (!threads_) {
+    // Groups must come from StrtcThreadGroup::create, a caller's own
+    // subclass has no threads to hand to the factory.
+    threads_ = std::dynamic_pointer_cast<StrtcThreadGroupImpl>(
+        config_.threads ? config_.threads
+                        : StrtcThreadGroup::create(config_.threadConfig));
+    if (!threads_) {
+      RTC_LOG(LS_ERROR) << __FUNCTION__
+                        << " thread group not created by StrtcThreadGroup";
       return false;
     }
   }
 
+  CodecFactories codecs;
+  if (config_.codecFactories) {
+    codecs = *config_.codecFactories;
+  }
   factory_ = webrtc::CreatePeerConnectionFactory(
-      nullptr, nullptr, signaling_thread_.get(), nullptr,
-      webrtc::CreateBuiltinAudioEncoderFactory(),
-      webrtc::CreateBuiltinAudioDecoderFactory(),
-      webrtc::CreateBuiltinVideoEncoderFactory(),
-      webrtc::CreateBuiltinVideoDecoderFactory(), nullptr, nullptr);
+      threads_->network(), threads_->worker(), threads_->signaling(), nullptr,
+      codecs.audioEncoder ? codecs.audioEncoder()
+                          : webrtc::CreateBuiltinAudioEncoderFactory(),
+      codecs.audioDecoder ? codecs.audioDecoder()
+                          : webrtc::CreateBuiltinAudioDecoderFactory(),
+      codecs.videoEncoder ? codecs.videoEncoder()
+                          : webrtc::CreateBuiltinVideoEncoderFactory(),
+      codecs.videoDecoder ? codecs.videoDecoder()
+                          : webrtc::CreateBuiltinVideoDecoderFactory(),
+      nullptr, nullptr);
 
   return factory_ != nullptr;
 }
 
 int StrtcEngine::createChannel(ChannelType type) {
-  if (!task_thread_->IsCurrent()) {
-    return task_thread_->Invoke<int>(
-        RTC_FROM_HERE, [this, &type]() { return createChannel(type); });
+  if (task_thread_->IsCurrent()) {
+    return doCreateChannel(type, defaultChannelOptions(), true);
+  }
+  int result = -1;
+  rtc::Event done;
+  createChannelAsync(type, [&result, &done](int channel_id) {
+    result = channel_id;
+    done.Set();
+  });
+  done.Wait(rtc::Event::kForever);
+  return result;
+}
+
+void StrtcEngine::createChannelAsync(
+    ChannelType type, std::function<void(int channel_id)> on_done) {
+  postCreateChannel(type, defaultChannelOptions(), true, on_done);
+}
+
+int StrtcEngine::createChannel(ChannelType type,
+                               const ChannelOptions& options) {
+  if (task_thread_->IsCurrent()) {
+    return doCreateChannel(type, options, false);
   }
+  int result = -1;
+  rtc::Event done;
+  createChannelAsync(type, options, [&result, &done](int channel_id) {
+    result = channel_id;
+    done.Set();
+  });
+  done.Wait(rtc::Event::kForever);
+  return result;
+}
+
+void StrtcEngine::createChannelAsync(
+    ChannelType type, const ChannelOptions& options,
+    std::function<void(int channel_id)> on_done) {
+  postCreateChannel(type, options, false, on_done);
+}
+
+void StrtcEngine::postCreateChannel(
+    ChannelType type, const ChannelOptions& options, bool use_pool,
+    std::function<void(int channel_id)> on_done) {
+  int64_t call_ms = rtc::TimeMillis();
+  task_thread_->PostTask(webrtc::ToQueuedTask(
+      [this, type, options, use_pool, on_done, call_ms]() {
+        int channel_id = doCreateChannel(type, options, use_pool);
+        api_latency_[API_CREATE_CHANNEL].add(rtc::TimeMillis() - call_ms);
+        if (on_done) {
+          on_done(channel_id);
+        }
+      }));
+}
+
+ChannelOptions StrtcEngine::defaultChannelOptions() {
+  ChannelOptions options;
+  options.ice = config_.ice;
+  options.videoCodecs = config_.videoCodecs;
+  return options;
+}
 
+int StrtcEngine::doCreateChannel(ChannelType type,
+                                 const ChannelOptions& options,
+                                 bool use_pool) {
   rtc::scoped_refptr<StrtcPeerConnectionChannel> pc_channel;
   if (type == ChannelType::PUBLISH) {
     if (!local_stream_) {
@@ -100,15 +322,24 @@ int StrtcEngine::createChannel(ChannelType type) {
 
     channel_id_++;
     pc_channel = rtc::make_ref_counted<StrtcPeerConnectionChannel>(
-        factory_, local_stream_->getMediaStream(), type, channel_id_, this);
+        factory_, local_stream_->getMediaStream(), type, channel_id_, this,
+        threads_->signaling(), http_loop_.get(), options);
   } else if (type == ChannelType::SUBSCRIBE) {
     channel_id_++;
     pc_channel = rtc::make_ref_counted<StrtcPeerConnectionChannel>(
-        factory_, nullptr, type, channel_id_, this);
+        factory_, nullptr, type, channel_id_, this, threads_->signaling(),
+        http_loop_.get(), options);
+    PooledPeerConnection pooled;
+    if (use_pool && subscribe_pool_ && subscribe_pool_->take(&pooled)) {
+      pc_channel->adoptPeerConnection(std::move(pooled));
+    }
   } else {
   }
 
   channel_map_[channel_id_] = pc_channel;
+  if (stats_collector_ && pc_channel) {
+    stats_collector_->addChannel(channel_id_, pc_channel);
+  }
 
   return channel_id_;
 }
@@ -116,29 +347,184 @@ int StrtcEngine::createChannel(ChannelType type) {
 void StrtcEngine::start(int channel_id, const std::string& url,
                         std::function<void()> on_success,
                         std::function<void(std::string error)> on_failure) {
+  int64_t queued_ms = rtc::TimeMillis();
+  task_thread_->PostTask(webrtc::ToQueuedTask([this, channel_id, url,
+                                               on_success, on_failure,
+                                               queued_ms]() {
+    auto it = channel_map_.find(channel_id);
+    if (it == channel_map_.end() || !it->second) {
+      RTC_LOG(LS_ERROR) << __FUNCTION__ << " channel id: " << channel_id
+                        << " not exist";
+      return;
+    }
+
+    scheduler_->schedule(
+        channel_id, url,
+        [this, channel_id, url, on_success, on_failure,
+         queued_ms](std::function<void()> done) {
+          // The channel may have been stopped while queued, look it up again
+          // and keep a reference for the callbacks. The channel drops them
+          // once the start completes or on stop(), which breaks the cycle.
+          auto it = channel_map_.find(channel_id);
+          if (it == channel_map_.end() || !it->second) {
+            done();
+            return;
+          }
+          rtc::scoped_refptr<StrtcPeerConnectionChannel> channel = it->second;
+          int64_t queue_ms = rtc::TimeMillis() - queued_ms;
+          channel->start(
+              url,
+              [this, channel, channel_id, on_success, done, queue_ms]() {
+                done();
+                ChannelSetupTimings timings = channel->getSetupTimings();
+                timings.queueMs = queue_ms;
+                timings.totalMs += queue_ms;
+                RTC_LOG(LS_INFO)
+                    << "channel id: " << channel_id
+                    << " setup queue: " << timings.queueMs
+                    << "ms offer: " << timings.createOfferMs
+                    << "ms signaling: " << timings.signalingMs
+                    << "ms remote: " << timings.setRemoteMs
+                    << "ms total: " << timings.totalMs << "ms";
+                if (observer_) {
+                  observer_->on_channel_setup(channel_id, timings);
+                }
+                if (on_success) {
+                  on_success();
+                }
+              },
+              [on_failure, done](std::string error) {
+                done();
+                if (on_failure) {
+                  on_failure(error);
+                }
+              });
+        });
+  }));
+}
+
+void StrtcEngine::setSimulcastLayerActive(int channel_id,
+                                          const std::string& rid,
+                                          bool active) {
   task_thread_->PostTask(
-      webrtc::ToQueuedTask([this, channel_id, url, on_success, on_failure]() {
+      webrtc::ToQueuedTask([this, channel_id, rid, active]() {
         auto it = channel_map_.find(channel_id);
-        if (it != channel_map_.end()) {
-          if (it->second) {
-            it->second->start(url, on_success, on_failure);
-          }
-        } else {
-          RTC_LOG(LS_ERROR)
-              << __FUNCTION__ << " channel id: " << channel_id << " not exist";
+        if (it == channel_map_.end() || !it->second) {
+          return;
+        }
+        if (!it->second->setSimulcastLayerActive(rid, active)) {
+          RTC_LOG(LS_WARNING) << __FUNCTION__ << " channel id: " << channel_id
+                              << " no layer " << rid;
+        }
+      }));
+}
+
+void StrtcEngine::setEncoderParameters(
+    int channel_id, const EncoderParameters& parameters,
+    std::function<void(bool success)> on_done) {
+  task_thread_->PostTask(
+      webrtc::ToQueuedTask([this, channel_id, parameters, on_done]() {
+        auto it = channel_map_.find(channel_id);
+        bool success = it != channel_map_.end() && it->second &&
+                       it->second->setEncoderParameters(parameters);
+        if (!success) {
+          RTC_LOG(LS_WARNING) << __FUNCTION__ << " channel id: " << channel_id
+                              << " rejected, rid: " << parameters.rid;
+        }
+        if (on_done) {
+          on_done(success);
         }
       }));
 }
 
 void StrtcEngine::stop(int channel_id) {
-  task_thread_->PostTask(webrtc::ToQueuedTask([this, channel_id]() {
-    auto it = channel_map_.find(channel_id);
-    if (it != channel_map_.end()) {
-      if (it->second) {
-        it->second->stop();
-      }
+  int64_t call_ms = rtc::TimeMillis();
+  task_thread_->PostTask(webrtc::ToQueuedTask(
+      [this, channel_id, call_ms]() { doStopChannel(channel_id, call_ms); }));
+}
+
+void StrtcEngine::doStopChannel(int channel_id, int64_t call_ms) {
+  scheduler_->cancel(channel_id);
+  removeFromVideoWall(channel_id);
+  removeRemoteVideoSink(channel_id);
+  if (stats_collector_) {
+    stats_collector_->removeChannel(channel_id);
+  }
+  encoder_limitations_.erase(channel_id);
+  auto it = channel_map_.find(channel_id);
+  if (it == channel_map_.end()) {
+    return;
+  }
+  rtc::scoped_refptr<StrtcPeerConnectionChannel> channel = it->second;
+  channel_map_.erase(it);
+  if (!channel) {
+    return;
+  }
+
+  channel->stop([this, channel_id, call_ms]() {
+    int64_t teardown_ms = rtc::TimeMillis() - call_ms;
+    api_latency_[API_STOP_CHANNEL].add(teardown_ms);
+    RTC_LOG(LS_INFO) << "channel id: " << channel_id
+                     << " teardown: " << teardown_ms << "ms";
+    if (observer_) {
+      observer_->on_channel_stopped(channel_id, teardown_ms);
     }
-  }));
+  });
+}
+
+LatencySummary StrtcEngine::getApiLatency(ApiCall call) {
+  if (call < API_START_STREAM || call > API_STOP_CHANNEL) {
+    return LatencySummary();
+  }
+  return api_latency_[call].summary();
+}
+
+std::vector<ThreadLoad> StrtcEngine::getThreadLoad() {
+  return threads_ ? threads_->getLoad() : std::vector<ThreadLoad>();
+}
+
+std::vector<ChannelStats> StrtcEngine::getChannelStats() {
+  return stats_collector_ ? stats_collector_->getStats()
+                          : std::vector<ChannelStats>();
+}
+
+std::string StrtcEngine::getStatsSnapshot(StatsFormat format) {
+  std::vector<ChannelStats> stats = getChannelStats();
+  return format == STATS_FORMAT_JSON ? StrtcStatsCollector::toJson(stats)
+                                     : StrtcStatsCollector::toPrometheus(stats);
+}
+
+std::vector<VideoDeviceInfo> StrtcEngine::getVideoDevices() {
+  return toVideoDeviceInfos(VideoDeviceRegistry::Instance()->GetDevices());
+}
+
+bool StrtcEngine::getCaptureFormat(CaptureFormatInfo* info) {
+  std::lock_guard<std::mutex> lock(capture_format_mutex_);
+  if (!capture_format_ || !info) {
+    return false;
+  }
+  *info = *capture_format_;
+  return true;
+}
+
+std::vector<CaptureSourceInfo> StrtcEngine::getCaptureSources(
+    StreamType type) {
+  std::vector<CaptureSourceInfo> infos;
+  if (type != STRREAM_TYPE_SCREEN && type != STRREAM_TYPE_WINDOW) {
+    return infos;
+  }
+  webrtc::DesktopCapturer::SourceList sources;
+  if (!ScreenCapturer::GetSources(type == STRREAM_TYPE_WINDOW, &sources)) {
+    RTC_LOG(LS_WARNING) << __FUNCTION__ << " no sources for type " << type;
+    return infos;
+  }
+  for (const auto& source : sources) {
+    CaptureSourceInfo info;
+    info.id = source.id;
+    info.title = source.title;
+    infos.push_back(info);
+  }
+  return infos;
 }
 
 void StrtcEngine::setLocalVideoRender(HWND wnd) {
@@ -160,6 +546,150 @@ void StrtcEngine::setRemoteVideoRender(int channel_id, HWND wnd) {
   }));
 }
 
+void StrtcEngine::setVideoWall(HWND wnd, int rows, int columns,
+                               int maxTileFps) {
+  task_thread_->PostTask(
+      webrtc::ToQueuedTask([this, wnd, rows, columns, maxTileFps]() {
+        for (const auto& it : wall_tiles_) {
+          auto channel = channel_map_.find(it.second.channel_id);
+          if (channel != channel_map_.end() && channel->second) {
+            channel->second->removeRemoteVideoSink(it.second.sink);
+          }
+        }
+        wall_tiles_.clear();
+        std::unique_ptr<VideoCompositor> previous_wall;
+        {
+          std::lock_guard<std::mutex> lock(video_wall_mutex_);
+          previous_wall = std::move(video_wall_);
+        }
+        // Joins the compositor thread, without blocking the stats getter.
+        previous_wall.reset();
+        if (!wnd || rows <= 0 || columns <= 0) {
+          return;
+        }
+
+        std::unique_ptr<GdiRenderSurface> surface(new GdiRenderSurface(wnd));
+        int width = 0;
+        int height = 0;
+        surface->GetTargetSize(&width, &height);
+        if (width <= 0 || height <= 0) {
+          width = kDefaultVideoWallWidth;
+          height = kDefaultVideoWallHeight;
+        }
+        std::unique_ptr<VideoCompositor> wall(
+            new VideoCompositor(std::move(surface), width, height));
+        {
+          std::lock_guard<std::mutex> lock(video_wall_mutex_);
+          video_wall_ = std::move(wall);
+        }
+        wall_rows_ = rows;
+        wall_columns_ = columns;
+        wall_max_fps_ = maxTileFps;
+      }));
+}
+
+void StrtcEngine::setRemoteVideoTile(int channel_id, int tile) {
+  task_thread_->PostTask(webrtc::ToQueuedTask([this, channel_id, tile]() {
+    auto it = channel_map_.find(channel_id);
+    if (it == channel_map_.end() || !it->second || !video_wall_) {
+      return;
+    }
+    removeFromVideoWall(channel_id);
+    if (tile < 0 || tile >= wall_rows_ * wall_columns_) {
+      return;
+    }
+    // The tile's previous channel gives it up.
+    auto previous = wall_tiles_.find(tile);
+    if (previous != wall_tiles_.end()) {
+      removeFromVideoWall(previous->second.channel_id);
+    }
+
+    int canvas_width = 0;
+    int canvas_height = 0;
+    video_wall_->GetSize(&canvas_width, &canvas_height);
+    int width = canvas_width / wall_columns_;
+    int height = canvas_height / wall_rows_;
+    int x = (tile % wall_columns_) * width;
+    int y = (tile / wall_columns_) * height;
+    rtc::VideoSinkWants wants;
+    wants.max_pixel_count = width * height;
+    wants.target_pixel_count = width * height;
+    if (wall_max_fps_ > 0) {
+      wants.max_framerate_fps = wall_max_fps_;
+    }
+    rtc::VideoSinkInterface<webrtc::VideoFrame>* sink =
+        video_wall_->AddTile(tile, x, y, width, height, wall_max_fps_);
+    it->second->addRemoteVideoSink(sink, wants);
+    wall_tiles_[tile] = {channel_id, sink};
+  }));
+}
+
+std::vector<VideoTileStats> StrtcEngine::getVideoWallStats() {
+  // VideoCompositor::GetStats() is thread safe, the lock only keeps the wall
+  // from being replaced meanwhile.
+  std::lock_guard<std::mutex> lock(video_wall_mutex_);
+  return video_wall_ ? video_wall_->GetStats() : std::vector<VideoTileStats>();
+}
+
+void StrtcEngine::removeFromVideoWall(int channel_id) {
+  for (auto it = wall_tiles_.begin(); it != wall_tiles_.end(); ++it) {
+    if (it->second.channel_id != channel_id) {
+      continue;
+    }
+    // Detached from the track before the tile sink goes away.
+    auto channel = channel_map_.find(channel_id);
+    if (channel != channel_map_.end() && channel->second) {
+      channel->second->removeRemoteVideoSink(it->second.sink);
+    }
+    if (video_wall_) {
+      video_wall_->RemoveTile(it->first);
+    }
+    wall_tiles_.erase(it);
+    return;
+  }
+}
+
+void StrtcEngine::setLocalVideoSink(std::shared_ptr<StrtcVideoSink> sink) {
+  task_thread_->PostTask(webrtc::ToQueuedTask([this, sink]() {
+    if (local_sink_ && local_stream_) {
+      local_stream_->removeVideoSink(local_sink_.get());
+    }
+    local_sink_.reset(sink ? new StrtcVideoSinkAdapter(sink) : nullptr);
+    if (local_sink_ && local_stream_) {
+      local_stream_->addVideoSink(local_sink_.get());
+    }
+  }));
+}
+
+void StrtcEngine::setRemoteVideoSink(int channel_id,
+                                     std::shared_ptr<StrtcVideoSink> sink) {
+  task_thread_->PostTask(webrtc::ToQueuedTask([this, channel_id, sink]() {
+    auto it = channel_map_.find(channel_id);
+    if (it == channel_map_.end() || !it->second) {
+      return;
+    }
+    removeRemoteVideoSink(channel_id);
+    if (sink) {
+      std::unique_ptr<StrtcVideoSinkAdapter>& adapter =
+          remote_sinks_[channel_id];
+      adapter.reset(new StrtcVideoSinkAdapter(sink));
+      it->second->addRemoteVideoSink(adapter.get());
+    }
+  }));
+}
+
+void StrtcEngine::removeRemoteVideoSink(int channel_id) {
+  auto it = remote_sinks_.find(channel_id);
+  if (it == remote_sinks_.end()) {
+    return;
+  }
+  auto channel = channel_map_.find(channel_id);
+  if (channel != channel_map_.end() && channel->second) {
+    channel->second->removeRemoteVideoSink(it->second.get());
+  }
+  remote_sinks_.erase(it);
+}
+
 void StrtcEngine::on_stream_failure(int channel_id, int code,
                                     std::string& error) {
   RTC_LOG(LS_ERROR) << __FUNCTION__ << " channel id: " << channel_id
@@ -168,4 +698,44 @@ void StrtcEngine::on_stream_failure(int channel_id, int code,
     observer_->on_stream_error(channel_id, code, error);
   }
 }
+
+void StrtcEngine::onChannelStats(const ChannelStats& stats) {
+  if (stats.type == PUBLISH) {
+    EncoderLimitation limitation = ENCODER_LIMITATION_NONE;
+    if (stats.qualityLimitationReason == "cpu") {
+      limitation = ENCODER_LIMITATION_CPU;
+    } else if (stats.qualityLimitationReason == "bandwidth") {
+      limitation = ENCODER_LIMITATION_BANDWIDTH;
+    } else if (stats.qualityLimitationReason == "other") {
+      limitation = ENCODER_LIMITATION_OTHER;
+    }
+    auto it = encoder_limitations_.find(stats.channelId);
+    EncoderLimitation previous =
+        it != encoder_limitations_.end() ? it->second : ENCODER_LIMITATION_NONE;
+    encoder_limitations_[stats.channelId] = limitation;
+    if (limitation != previous) {
+      RTC_LOG(LS_INFO) << __FUNCTION__ << " channel id: " << stats.channelId
+                       << " encoder limited by: "
+                       << stats.qualityLimitationReason;
+      if (observer_) {
+        observer_->on_encoder_limitation_changed(stats.channelId, limitation);
+      }
+    }
+  }
+  if (observer_) {
+    observer_->on_channel_stats(stats);
+  }
+}
+
+void StrtcEngine::on_latency(int channel_id, const LatencySummary& latency) {
+  task_thread_->PostTask(
+      webrtc::ToQueuedTask([this, channel_id, latency]() {
+        RTC_LOG(LS_INFO) << __FUNCTION__ << " channel id: " << channel_id
+                         << " p50: " << latency.p50Ms
+                         << "ms p99: " << latency.p99Ms << "ms";
+        if (observer_) {
+          observer_->on_glass_to_glass_latency(channel_id, latency);
+        }
+      }));
+}
 }  // namespace strtc
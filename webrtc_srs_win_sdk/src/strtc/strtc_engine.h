@@ -2,11 +2,21 @@
 #define STRTC_ENGINE_H_
 
 #include <map>
+#include <mutex>
 
+#include "absl/types/optional.h"
 #include "rtc_base/thread.h"
+#include "strtc_channel_scheduler.h"
 #include "strtc_engine_interface.h"
+#include "strtc_http_request_loop.h"
+#include "strtc_latency_histogram.h"
 #include "strtc_media_stream.h"
 #include "strtc_peer_connection_channel.h"
+#include "strtc_stats_collector.h"
+#include "strtc_thread_group_impl.h"
+#include "strtc_video_compositor.h"
+#include "strtc_video_device_registry.h"
+#include "strtc_video_sinks.h"
 
 namespace strtc {
 class StrtcEngine : public StrtcEngineInterface,
@@ -16,39 +26,124 @@ class StrtcEngine : public StrtcEngineInterface,
   ~StrtcEngine();
 
   virtual bool init() override;
+  virtual bool init(const StrtcEngineConfig& config) override;
 
   virtual bool startStream(StreamOptions& options) override;
+  virtual void startStreamAsync(
+      const StreamOptions& options,
+      std::function<void(bool success)> on_done) override;
   virtual void stopStream() override;
+  virtual void stopStreamAsync(std::function<void()> on_done) override;
 
   virtual void setLocalVideoRender(HWND wnd) override;
   virtual void setRemoteVideoRender(int channel_id, HWND wnd) override;
+  virtual void setVideoWall(HWND wnd, int rows, int columns,
+                            int maxTileFps) override;
+  virtual void setRemoteVideoTile(int channel_id, int tile) override;
+  virtual std::vector<VideoTileStats> getVideoWallStats() override;
+  virtual void setLocalVideoSink(std::shared_ptr<StrtcVideoSink> sink) override;
+  virtual void setRemoteVideoSink(int channel_id,
+                                  std::shared_ptr<StrtcVideoSink> sink) override;
   virtual void muteLocalAudio(bool mute) override{};
   virtual void muteLocalVideo(bool mute) override{};
   virtual int createChannel(ChannelType type) override;
+  virtual void createChannelAsync(
+      ChannelType type, std::function<void(int channel_id)> on_done) override;
+  virtual int createChannel(ChannelType type,
+                            const ChannelOptions& options) override;
+  virtual void createChannelAsync(
+      ChannelType type, const ChannelOptions& options,
+      std::function<void(int channel_id)> on_done) override;
 
   virtual void start(
       int channel_id, const std::string& url, std::function<void()> on_success,
       std::function<void(std::string error)> on_failure) override;
+  virtual void setSimulcastLayerActive(int channel_id, const std::string& rid,
+                                       bool active) override;
+  virtual void setEncoderParameters(
+      int channel_id, const EncoderParameters& parameters,
+      std::function<void(bool success)> on_done) override;
   virtual void stop(int channel_id) override;
 
+  virtual LatencySummary getApiLatency(ApiCall call) override;
+  virtual std::vector<ThreadLoad> getThreadLoad() override;
+  virtual std::vector<VideoDeviceInfo> getVideoDevices() override;
+  virtual bool getCaptureFormat(CaptureFormatInfo* info) override;
+  virtual std::vector<CaptureSourceInfo> getCaptureSources(
+      StreamType type) override;
+  virtual std::vector<ChannelStats> getChannelStats() override;
+  virtual std::string getStatsSnapshot(StatsFormat format) override;
+
  private:
   bool createPeerConnectionFactory();
 
+  // Bodies of the public calls, run on task_thread_.
+  bool doStartStream(StreamOptions options);
+  void doStopStream();
+  // Publishes `format` for getCaptureFormat(), nullptr clears it.
+  void setCaptureFormat(const CaptureFormat* format);
+  void postCreateChannel(ChannelType type, const ChannelOptions& options,
+                         bool use_pool,
+                         std::function<void(int channel_id)> on_done);
+  int doCreateChannel(ChannelType type, const ChannelOptions& options,
+                      bool use_pool);
+  ChannelOptions defaultChannelOptions();
+  void doStopChannel(int channel_id, int64_t call_ms);
+  void removeFromVideoWall(int channel_id);
+  void removeRemoteVideoSink(int channel_id);
+  // StrtcStatsCollector results, on task_thread_.
+  void onChannelStats(const ChannelStats& stats);
+
   virtual void on_stream_failure(int channel_id, int code,
                                  std::string& error) override;
+  virtual void on_latency(int channel_id,
+                          const LatencySummary& latency) override;
 
  private:
   std::unique_ptr<rtc::Thread> task_thread_;
+  std::unique_ptr<HttpRequestLoop> http_loop_;
+  std::unique_ptr<StrtcChannelScheduler> scheduler_;
 
-  std::unique_ptr<rtc::Thread> signaling_thread_;
+  std::shared_ptr<StrtcThreadGroupImpl> threads_;
   rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory_;
+  std::unique_ptr<StrtcPeerConnectionPool> subscribe_pool_;
+  std::unique_ptr<StrtcStatsCollector> stats_collector_;
+  // channel id -> last reported encoder limitation.
+  std::map<int, EncoderLimitation> encoder_limitations_;
 
+  // Outlives the local stream, whose tracks may still hold it.
+  std::unique_ptr<StrtcVideoSinkAdapter> local_sink_;
   std::unique_ptr<StrtcMediaStream> local_stream_;
+  // Copy of the local camera's format, set and cleared with local_stream_
+  // on the task thread, read by getCaptureFormat() from any thread.
+  std::mutex capture_format_mutex_;
+  absl::optional<CaptureFormatInfo> capture_format_;
+
+  // Outlives the channels, whose tracks may still hold its tile sinks.
+  // Replaced on the task thread with video_wall_mutex_ held, which
+  // getVideoWallStats() takes instead of waiting for the task thread.
+  std::mutex video_wall_mutex_;
+  std::unique_ptr<VideoCompositor> video_wall_;
+  int wall_rows_ = 0;
+  int wall_columns_ = 0;
+  int wall_max_fps_ = 0;
+  struct WallTile {
+    int channel_id;
+    rtc::VideoSinkInterface<webrtc::VideoFrame>* sink;
+  };
+  std::map<int, WallTile> wall_tiles_;
+  // channel id -> user sink.
+  std::map<int, std::unique_ptr<StrtcVideoSinkAdapter>> remote_sinks_;
 
   int channel_id_;
   std::map<int, rtc::scoped_refptr<StrtcPeerConnectionChannel>> channel_map_;
 
+  LatencyHistogram api_latency_[API_STOP_CHANNEL + 1];
+
+  StrtcEngineConfig config_;
   StrtcEngineObserver* observer_;
+  // VideoDeviceRegistry listener, -1 before init().
+  int device_listener_ = -1;
 };
 }  // namespace strtc
 #endif  // STRTC_ENGINE_H_
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "strtc_frame_generator_capturer.h"
+
+#include <stdio.h>
+
+#include <chrono>
+
+#include "api/test/create_frame_generator.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/time_utils.h"
+
+#if defined(WEBRTC_WIN)
+#include <windows.h>
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#endif  // WEBRTC_WIN
+
+namespace strtc {
+namespace {
+// m99 only RTC_DCHECKs the fopen() of the YUV file generator, a release
+// build would crash on the first frame instead. True if `file` holds at
+// least one I420 frame of width x height.
+bool HasYuvFrame(const std::string& file, int width, int height) {
+  FILE* fp = fopen(file.c_str(), "rb");
+  if (!fp) {
+    RTC_LOG(LS_ERROR) << "cannot open yuv file " << file;
+    return false;
+  }
+  // The offset of the last byte of the first frame, small enough for fseek.
+  long last_byte = static_cast<long>(width) * height * 3 / 2 - 1;
+  bool complete = fseek(fp, last_byte, SEEK_SET) == 0 && fgetc(fp) != EOF;
+  fclose(fp);
+  if (!complete) {
+    RTC_LOG(LS_ERROR) << "yuv file " << file << " is shorter than one "
+                      << width << "x" << height << " I420 frame";
+  }
+  return complete;
+}
+}  // namespace
+
+std::unique_ptr<FrameGeneratorCapturer> FrameGeneratorCapturer::Create(
+    int width, int height, int fps, const std::string& file) {
+  if (width <= 0 || height <= 0 || fps <= 0) {
+    return nullptr;
+  }
+  std::unique_ptr<webrtc::test::FrameGeneratorInterface> generator;
+  if (file.empty()) {
+    generator = webrtc::test::CreateSquareFrameGenerator(
+        width, height, webrtc::test::FrameGeneratorInterface::OutputType::kI420,
+        absl::nullopt);
+  } else {
+    if (!HasYuvFrame(file, width, height)) {
+      return nullptr;
+    }
+    generator = webrtc::test::CreateFromYuvFileFrameGenerator(
+        {file}, width, height, /*frame_repeat_count=*/1);
+  }
+  if (!generator) {
+    RTC_LOG(LS_ERROR) << __FUNCTION__ << " create frame generator failed";
+    return nullptr;
+  }
+  return std::unique_ptr<FrameGeneratorCapturer>(
+      new FrameGeneratorCapturer(std::move(generator), fps));
+}
+
+FrameGeneratorCapturer::FrameGeneratorCapturer(
+    std::unique_ptr<webrtc::test::FrameGeneratorInterface> generator, int fps)
+    : generator_(std::move(generator)), fps_(fps), skipped_(0) {
+  thread_ = std::thread([this]() { Run(); });
+}
+
+FrameGeneratorCapturer::~FrameGeneratorCapturer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+  }
+  cond_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  RTC_LOG(LS_INFO) << __FUNCTION__ << " skipped frames: " << skipped_;
+}
+
+void FrameGeneratorCapturer::Run() {
+#if defined(WEBRTC_WIN)
+  // The default 15.6 ms timer resolution would round every frame interval.
+  timeBeginPeriod(1);
+#endif  // WEBRTC_WIN
+
+  // Frames are due on an absolute schedule, so wake up jitter does not add
+  // up over time.
+  const std::chrono::microseconds interval(rtc::kNumMicrosecsPerSec / fps_);
+  auto next_frame = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!cond_.wait_until(lock, next_frame, [this]() { return stopped_; })) {
+    lock.unlock();
+    webrtc::test::FrameGeneratorInterface::VideoFrameData data =
+        generator_->NextFrame();
+    webrtc::VideoFrame::Builder builder;
+    builder.set_video_frame_buffer(data.buffer)
+        .set_timestamp_us(rtc::TimeMicros())
+        .set_rotation(webrtc::kVideoRotation_0);
+    if (data.update_rect) {
+      builder.set_update_rect(*data.update_rect);
+    }
+    OnFrame(builder.build());
+    lock.lock();
+
+    next_frame += interval;
+    // Fell more than a frame behind, skip the missed ones instead of
+    // bursting them out.
+    auto now = std::chrono::steady_clock::now();
+    while (next_frame + interval < now) {
+      next_frame += interval;
+      ++skipped_;
+    }
+  }
+
+#if defined(WEBRTC_WIN)
+  timeEndPeriod(1);
+#endif  // WEBRTC_WIN
+}
+}  // namespace strtc
@@ -0,0 +1,46 @@
+#ifndef STRTC_FRAME_GENERATOR_CAPTURER_H_
+#define STRTC_FRAME_GENERATOR_CAPTURER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "api/test/frame_generator_interface.h"
+#include "test/test_video_capturer.h"
+
+namespace strtc {
+// Capturer without a camera: frames come from a webrtc::test frame
+// generator, moving squares or a raw I420 file played in a loop, and are
+// delivered at a fixed rate from an own thread.
+class FrameGeneratorCapturer : public webrtc::test::TestVideoCapturer {
+ public:
+  // `file` empty generates squares.
+  static std::unique_ptr<FrameGeneratorCapturer> Create(
+      int width, int height, int fps, const std::string& file);
+  ~FrameGeneratorCapturer() override;
+
+  // Frames that could not be delivered on time and were skipped.
+  int64_t skipped() const { return skipped_; }
+
+ private:
+  FrameGeneratorCapturer(
+      std::unique_ptr<webrtc::test::FrameGeneratorInterface> generator,
+      int fps);
+
+  void Run();
+
+ private:
+  std::unique_ptr<webrtc::test::FrameGeneratorInterface> generator_;
+  const int fps_;
+  std::atomic<int64_t> skipped_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  bool stopped_ = false;
+  std::thread thread_;
+};
+}  // namespace strtc
+#endif  // STRTC_FRAME_GENERATOR_CAPTURER_H_
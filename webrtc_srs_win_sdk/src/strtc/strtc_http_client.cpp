@@ -1,138 +1,227 @@
-#include "strtc_http_client.h"
-
-#ifndef CURL_STATICLIB
-#define CURL_STATICLIB
-#endif
-#include "curl/curl.h"
-
-#if defined(WIN32)
-#pragma comment(lib, "ws2_32.lib")
-#pragma comment(lib, "wldap32.lib")
-#endif
-
-#include <mutex>
-
-namespace strtc {
-#define MAX_CONTENT_SIZE 20000
-
-static int global_http_client_count = 0;
-static std::mutex global_http_client_sync_mutex;
-
-HttpClient::HttpClient(const std::string & url, int timeout, int conn_timeout_ms) 
-    : url_(url) {
-  Init();
-
-  curl_handle_ = curl_easy_init();
-  if (!curl_handle_) {
-    return;
-  }
-
-  if (timeout > 0) {
-    curl_easy_setopt(curl_handle_, CURLOPT_NOSIGNAL, 1L);
-    curl_easy_setopt(curl_handle_, CURLOPT_TIMEOUT_MS, timeout);
-    curl_easy_setopt(curl_handle_, CURLOPT_CONNECTTIMEOUT_MS, conn_timeout_ms);
-    curl_easy_setopt(curl_handle_, CURLOPT_VERBOSE, 1L);
-  }
-
-  curl_easy_setopt(curl_handle_, CURLOPT_URL, url.c_str());
-  SetSharedHandler();
-}
-
-HttpClient::~HttpClient() {
-  if (curl_list_) {
-    curl_slist_free_all(curl_list_);
-  }
-
-  if (curl_handle_) {
-    curl_easy_cleanup(curl_handle_);
-  }
-
-  Unit();
-}
-
-void HttpClient::Init() {
-  std::lock_guard<std::mutex> lock(global_http_client_sync_mutex);
-  if (global_http_client_count == 0) {
-    curl_global_init(CURL_GLOBAL_ALL);
-  }
-  ++global_http_client_count;
-}
-
-void HttpClient::Unit() {
-  std::lock_guard<std::mutex> lock(global_http_client_sync_mutex);
-  --global_http_client_count;
-  if (global_http_client_count == 0) {
-    curl_global_cleanup();
-  }
-}
-
-void HttpClient::AddHeader(const std::string& name, const std::string& value) {
-  std::string header = name + ":" + value;
-  curl_list_ = curl_slist_append(curl_list_, header.c_str());
-  curl_easy_setopt(curl_handle_, CURLOPT_HTTPHEADER, curl_list_);
-}
-
-void HttpClient::AddContent(bool post, const std::string& form_post, const std::string& post_field) {
-  if (!form_post.empty()) {
-    curl_easy_setopt(curl_handle_, CURLOPT_HTTPPOST, form_post.c_str());
-  } else {
-    if (!post_field.empty()) {
-      curl_easy_setopt(curl_handle_, CURLOPT_POSTFIELDS, post_field.c_str());
-    }
-  }
-
-  if (url_.substr(0, 8) == "https://") {
-    curl_easy_setopt(curl_handle_, CURLOPT_SSL_VERIFYHOST, 2);
-    curl_easy_setopt(curl_handle_, CURLOPT_SSL_VERIFYPEER, 0);
-  }
-
-  curl_easy_setopt(curl_handle_, CURLOPT_WRITEDATA, this);
-  curl_easy_setopt(curl_handle_, CURLOPT_WRITEFUNCTION, HttpClient::WriteMemory);
-}
-
-void HttpClient::SetSharedHandler() {
-  static CURLSH* shared_handler = nullptr;
-  if (!shared_handler) {
-    shared_handler = curl_share_init();
-    curl_share_setopt(shared_handler, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
-  }
-  curl_easy_setopt(curl_handle_, CURLOPT_SHARE, shared_handler);
-  curl_easy_setopt(curl_handle_, CURLOPT_DNS_CACHE_TIMEOUT, 60*5);
-}
-
-int HttpClient::DoEasy() {
-  CURLcode code = CURL_LAST;
-  if (curl_handle_) {
-    code = curl_easy_perform(curl_handle_);
-  }
-  return code;
-}
-
-std::string HttpClient::GetContent() {
-  return content_;
-}
-
-long HttpClient::GetHttpStatusCode() {
-  long http_code = -1;
-  if (curl_handle_) {
-    curl_easy_getinfo(curl_handle_, CURLINFO_RESPONSE_CODE, &http_code);
-  }
-  return http_code;
-}
-
-size_t HttpClient::WriteMemory(void* data, size_t size, size_t count, void * param) {
-  if (data == nullptr) {
-    return 0;
-  }
-
-  size_t data_bytes = size * count;
-  HttpClient* http_client = (HttpClient *)param;
-  int total_bytes = http_client->content_bytes_ + data_bytes;
-  if (total_bytes > MAX_CONTENT_SIZE) {
-    return data_bytes;
-  }
-  http_client->content_.append((const char*)data, data_bytes);
-  http_client->content_bytes_ = total_bytes;
-  return data_bytes;
-}
-}
+#include "strtc_http_client.h"
+
+#ifndef CURL_STATICLIB
+#define CURL_STATICLIB
+#endif
+#include "curl/curl.h"
+
+#if defined(WIN32)
+#pragma comment(lib, "ws2_32.lib")
+#pragma comment(lib, "wldap32.lib")
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+
+namespace strtc {
+// Responses larger than this abort the request instead of being truncated.
+#define MAX_CONTENT_SIZE (16 * 1024 * 1024)
+// Cached connections idle longer than this are closed instead of reused.
+#define MAX_CONNECTION_IDLE_SECONDS 60
+
+static int global_http_client_count = 0;
+static std::mutex global_http_client_sync_mutex;
+static std::mutex global_share_mutex[CURL_LOCK_DATA_LAST];
+// Shared by every easy handle, created with the first request and released
+// with the last HttpClient together with the curl globals.
+static CURLSH* global_share_handle = nullptr;
+
+static void ShareLock(CURL* handle, curl_lock_data data,
+                      curl_lock_access access, void* userptr) {
+  global_share_mutex[data].lock();
+}
+
+static void ShareUnlock(CURL* handle, curl_lock_data data, void* userptr) {
+  global_share_mutex[data].unlock();
+}
+
+HttpClient::HttpClient(const std::string & url, int timeout, int conn_timeout_ms) 
+    : url_(url) {
+  Init();
+
+  curl_handle_ = curl_easy_init();
+  if (!curl_handle_) {
+    return;
+  }
+
+  if (timeout > 0) {
+    curl_easy_setopt(curl_handle_, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl_handle_, CURLOPT_TIMEOUT_MS, timeout);
+    curl_easy_setopt(curl_handle_, CURLOPT_CONNECTTIMEOUT_MS, conn_timeout_ms);
+    curl_easy_setopt(curl_handle_, CURLOPT_VERBOSE, 1L);
+  }
+
+  curl_easy_setopt(curl_handle_, CURLOPT_URL, url.c_str());
+  SetSharedHandler();
+}
+
+HttpClient::~HttpClient() {
+  if (curl_list_) {
+    curl_slist_free_all(curl_list_);
+  }
+
+  if (curl_handle_) {
+    curl_easy_cleanup(curl_handle_);
+  }
+
+  Unit();
+}
+
+void HttpClient::Init() {
+  std::lock_guard<std::mutex> lock(global_http_client_sync_mutex);
+  if (global_http_client_count == 0) {
+    curl_global_init(CURL_GLOBAL_ALL);
+  }
+  ++global_http_client_count;
+}
+
+void HttpClient::Unit() {
+  std::lock_guard<std::mutex> lock(global_http_client_sync_mutex);
+  --global_http_client_count;
+  if (global_http_client_count == 0) {
+    if (global_share_handle) {
+      curl_share_cleanup(global_share_handle);
+      global_share_handle = nullptr;
+    }
+    curl_global_cleanup();
+  }
+}
+
+void HttpClient::AddHeader(const std::string& name, const std::string& value) {
+  std::string header = name + ":" + value;
+  curl_list_ = curl_slist_append(curl_list_, header.c_str());
+  curl_easy_setopt(curl_handle_, CURLOPT_HTTPHEADER, curl_list_);
+}
+
+void HttpClient::AddContent(bool post, const std::string& form_post, const std::string& post_field) {
+  if (!form_post.empty()) {
+    curl_easy_setopt(curl_handle_, CURLOPT_HTTPPOST, form_post.c_str());
+  } else {
+    if (!post_field.empty()) {
+      // curl keeps a pointer to the body, it must outlive the request.
+      post_field_ = post_field;
+      curl_easy_setopt(curl_handle_, CURLOPT_POSTFIELDSIZE,
+                       static_cast<long>(post_field_.size()));
+      curl_easy_setopt(curl_handle_, CURLOPT_POSTFIELDS, post_field_.c_str());
+    }
+  }
+
+  if (url_.substr(0, 8) == "https://") {
+    curl_easy_setopt(curl_handle_, CURLOPT_SSL_VERIFYHOST, 2);
+    curl_easy_setopt(curl_handle_, CURLOPT_SSL_VERIFYPEER, 0);
+  }
+
+  curl_easy_setopt(curl_handle_, CURLOPT_WRITEDATA, this);
+  curl_easy_setopt(curl_handle_, CURLOPT_WRITEFUNCTION, HttpClient::WriteMemory);
+  curl_easy_setopt(curl_handle_, CURLOPT_HEADERDATA, this);
+  curl_easy_setopt(curl_handle_, CURLOPT_HEADERFUNCTION, HttpClient::WriteHeader);
+}
+
+void HttpClient::SetMethod(const std::string& method) {
+  if (curl_handle_) {
+    curl_easy_setopt(curl_handle_, CURLOPT_CUSTOMREQUEST, method.c_str());
+  }
+}
+
+void HttpClient::SetSharedHandler() {
+  CURLSH* shared_handler = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(global_http_client_sync_mutex);
+    if (!global_share_handle) {
+      // Requests run on several threads, so the share needs locking. Sharing
+      // connections and tls sessions lets a new request to a known SRS reuse
+      // an open connection or resume the tls session, whether it runs with
+      // curl_easy_perform or on the http loop's multi handle.
+      global_share_handle = curl_share_init();
+      curl_share_setopt(global_share_handle, CURLSHOPT_LOCKFUNC, ShareLock);
+      curl_share_setopt(global_share_handle, CURLSHOPT_UNLOCKFUNC, ShareUnlock);
+      curl_share_setopt(global_share_handle, CURLSHOPT_SHARE,
+                        CURL_LOCK_DATA_DNS);
+      curl_share_setopt(global_share_handle, CURLSHOPT_SHARE,
+                        CURL_LOCK_DATA_SSL_SESSION);
+      curl_share_setopt(global_share_handle, CURLSHOPT_SHARE,
+                        CURL_LOCK_DATA_CONNECT);
+    }
+    shared_handler = global_share_handle;
+  }
+  curl_easy_setopt(curl_handle_, CURLOPT_SHARE, shared_handler);
+  curl_easy_setopt(curl_handle_, CURLOPT_DNS_CACHE_TIMEOUT, 60*5);
+  curl_easy_setopt(curl_handle_, CURLOPT_TCP_KEEPALIVE, 1L);
+  curl_easy_setopt(curl_handle_, CURLOPT_MAXAGE_CONN,
+                   static_cast<long>(MAX_CONNECTION_IDLE_SECONDS));
+}
+
+int HttpClient::DoEasy() {
+  CURLcode code = CURL_LAST;
+  if (curl_handle_) {
+    code = curl_easy_perform(curl_handle_);
+  }
+  return code;
+}
+
+long HttpClient::GetHttpStatusCode() {
+  long http_code = -1;
+  if (curl_handle_) {
+    curl_easy_getinfo(curl_handle_, CURLINFO_RESPONSE_CODE, &http_code);
+  }
+  return http_code;
+}
+
+std::string HttpClient::GetHeader(const std::string& name) const {
+  std::string key(name);
+  std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+  auto it = headers_.find(key);
+  return it != headers_.end() ? it->second : std::string();
+}
+
+size_t HttpClient::WriteMemory(void* data, size_t size, size_t count, void * param) {
+  if (data == nullptr) {
+    return 0;
+  }
+
+  size_t data_bytes = size * count;
+  HttpClient* http_client = (HttpClient *)param;
+  if (http_client->content_.size() + data_bytes > MAX_CONTENT_SIZE) {
+    // Returning less than data_bytes fails the request with
+    // CURLE_WRITE_ERROR, a truncated sdp would only fail later in parsing.
+    return 0;
+  }
+  http_client->content_.append((const char*)data, data_bytes);
+  return data_bytes;
+}
+
+size_t HttpClient::WriteHeader(char* data, size_t size, size_t count, void* param) {
+  size_t data_bytes = size * count;
+  HttpClient* http_client = (HttpClient *)param;
+
+  std::string line(data, data_bytes);
+  size_t colon = line.find(':');
+  if (colon == std::string::npos) {
+    // Status line of a new response (e.g. after a redirect).
+    if (line.compare(0, 5, "HTTP/") == 0) {
+      http_client->headers_.clear();
+    }
+    return data_bytes;
+  }
+
+  std::string name = line.substr(0, colon);
+  std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+  size_t value_begin = line.find_first_not_of(" \t", colon + 1);
+  size_t value_end = line.find_last_not_of(" \t\r\n");
+  std::string value;
+  if (value_begin != std::string::npos && value_end >= value_begin) {
+    value = line.substr(value_begin, value_end - value_begin + 1);
+  }
+
+  // Reserve the whole body up front so WriteMemory never reallocates.
+  if (name == "content-length") {
+    long long length = std::strtoll(value.c_str(), nullptr, 10);
+    if (length > 0 && length <= MAX_CONTENT_SIZE) {
+      http_client->content_.reserve(static_cast<size_t>(length));
+    }
+  }
+  http_client->headers_[name] = value;
+  return data_bytes;
+}
+}
@@ -0,0 +1,169 @@
+#include "strtc_http_request_loop.h"
+
+#ifndef CURL_STATICLIB
+#define CURL_STATICLIB
+#endif
+#include "curl/curl.h"
+#include "rtc_base/logging.h"
+
+namespace strtc {
+constexpr int kLoopPollTimeoutMs = 1000;
+
+HttpRequestLoop::HttpRequestLoop() {
+  HttpClient::Init();
+  multi_handle_ = curl_multi_init();
+}
+
+HttpRequestLoop::~HttpRequestLoop() {
+  Stop();
+
+  if (multi_handle_) {
+    curl_multi_cleanup(multi_handle_);
+  }
+
+  HttpClient::Unit();
+}
+
+bool HttpRequestLoop::Start() {
+  if (!multi_handle_) {
+    RTC_LOG(LS_ERROR) << __FUNCTION__ << " curl multi handle is nullptr";
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!stopped_) {
+    return true;
+  }
+  stopped_ = false;
+  thread_ = std::thread(&HttpRequestLoop::Run, this);
+  return true;
+}
+
+void HttpRequestLoop::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopped_) {
+      return;
+    }
+    stopped_ = true;
+  }
+  curl_multi_wakeup(multi_handle_);
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+
+  std::vector<Request> aborted;
+  for (auto& it : running_) {
+    curl_multi_remove_handle(multi_handle_, it.first);
+    aborted.push_back(std::move(it.second));
+  }
+  running_.clear();
+  std::vector<Request> pending;
+  {
+    // Perform() queues nothing once stopped_ is set.
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending.swap(pending_);
+  }
+  for (auto& request : pending) {
+    aborted.push_back(std::move(request));
+  }
+  // Outside the lock, a callback may Perform() again and fail inline.
+  for (auto& request : aborted) {
+    if (request.callback) {
+      request.callback(CURLE_ABORTED_BY_CALLBACK, request.client.get());
+    }
+  }
+}
+
+void HttpRequestLoop::Perform(std::unique_ptr<HttpClient> client,
+                              Callback callback) {
+  if (!client || !client->GetHandle()) {
+    if (callback) {
+      callback(CURLE_FAILED_INIT, client.get());
+    }
+    return;
+  }
+
+  bool stopped = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped = stopped_;
+    if (!stopped) {
+      pending_.push_back({std::move(client), std::move(callback)});
+    }
+  }
+  if (stopped) {
+    RTC_LOG(LS_WARNING) << __FUNCTION__ << " loop stopped, request failed";
+    if (callback) {
+      callback(CURLE_FAILED_INIT, client.get());
+    }
+    return;
+  }
+  curl_multi_wakeup(multi_handle_);
+}
+
+void HttpRequestLoop::Run() {
+  while (true) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopped_) {
+        break;
+      }
+    }
+
+    AddPendingRequests();
+
+    int still_running = 0;
+    CURLMcode code = curl_multi_perform(multi_handle_, &still_running);
+    if (code != CURLM_OK) {
+      RTC_LOG(LS_ERROR) << __FUNCTION__
+                        << " curl multi perform failed code:" << code;
+    }
+
+    CompleteRequests();
+
+    curl_multi_poll(multi_handle_, nullptr, 0, kLoopPollTimeoutMs, nullptr);
+  }
+}
+
+void HttpRequestLoop::AddPendingRequests() {
+  std::vector<Request> requests;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests.swap(pending_);
+  }
+
+  for (auto& request : requests) {
+    void* handle = request.client->GetHandle();
+    if (curl_multi_add_handle(multi_handle_, handle) != CURLM_OK) {
+      if (request.callback) {
+        request.callback(CURLE_FAILED_INIT, request.client.get());
+      }
+      continue;
+    }
+    running_[handle] = std::move(request);
+  }
+}
+
+void HttpRequestLoop::CompleteRequests() {
+  int msgs_in_queue = 0;
+  CURLMsg* msg = nullptr;
+  while ((msg = curl_multi_info_read(multi_handle_, &msgs_in_queue))) {
+    if (msg->msg != CURLMSG_DONE) {
+      continue;
+    }
+
+    auto it = running_.find(msg->easy_handle);
+    if (it == running_.end()) {
+      continue;
+    }
+    Request request = std::move(it->second);
+    running_.erase(it);
+    curl_multi_remove_handle(multi_handle_, msg->easy_handle);
+
+    if (request.callback) {
+      request.callback(msg->data.result, request.client.get());
+    }
+  }
+}
+}  // namespace strtc
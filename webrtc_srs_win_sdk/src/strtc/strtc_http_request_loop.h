@@ -0,0 +1,58 @@
+#ifndef STRTC_HTTP_REQUEST_LOOP_H_
+#define STRTC_HTTP_REQUEST_LOOP_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "strtc_http_client.h"
+
+namespace strtc {
+// Drives HttpClient requests through a single curl multi handle on its own
+// I/O thread, so any number of requests can be in flight at once without
+// blocking the caller.
+class HttpRequestLoop {
+ public:
+  // Called on the loop thread once the request has finished. `code` is the
+  // CURLcode of the transfer.
+  using Callback = std::function<void(int code, HttpClient* client)>;
+
+  HttpRequestLoop();
+  ~HttpRequestLoop();
+
+  bool Start();
+  // Joins the loop thread, then aborts every queued or in-flight request:
+  // their callbacks run on the calling thread with CURLE_ABORTED_BY_CALLBACK.
+  void Stop();
+
+  // Queues `client` for transfer. The callback always runs exactly once: on
+  // the loop thread when the transfer finishes, from Stop() when it is
+  // aborted, or inline with CURLE_FAILED_INIT if the loop is not running.
+  void Perform(std::unique_ptr<HttpClient> client, Callback callback);
+
+ private:
+  struct Request {
+    std::unique_ptr<HttpClient> client;
+    Callback callback;
+  };
+
+  void Run();
+  void AddPendingRequests();
+  void CompleteRequests();
+
+ private:
+  void* multi_handle_ = nullptr;
+  std::thread thread_;
+
+  std::mutex mutex_;
+  bool stopped_ = true;
+  std::vector<Request> pending_;
+
+  // Only touched on the loop thread.
+  std::map<void*, Request> running_;
+};
+}  // namespace strtc
+#endif  // STRTC_HTTP_REQUEST_LOOP_H_
@@ -0,0 +1,77 @@
+#include "strtc_latency_histogram.h"
+
+#include <algorithm>
+
+namespace strtc {
+constexpr size_t kBucketCount = 100 + 90 + 90 + 1;
+
+LatencyHistogram::LatencyHistogram() : buckets_(kBucketCount, 0) {}
+
+void LatencyHistogram::add(int64_t latency_ms) {
+  latency_ms = std::max<int64_t>(latency_ms, 0);
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++buckets_[bucketOf(latency_ms)];
+  ++count_;
+  sum_ms_ += latency_ms;
+  max_ms_ = std::max(max_ms_, latency_ms);
+}
+
+void LatencyHistogram::reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::fill(buckets_.begin(), buckets_.end(), 0);
+  count_ = 0;
+  sum_ms_ = 0;
+  max_ms_ = 0;
+}
+
+LatencySummary LatencyHistogram::summary() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  LatencySummary summary;
+  summary.count = count_;
+  if (count_ == 0) {
+    return summary;
+  }
+  summary.avgMs = static_cast<double>(sum_ms_) / count_;
+  summary.p50Ms = percentileLocked((count_ * 50 + 99) / 100);
+  summary.p90Ms = percentileLocked((count_ * 90 + 99) / 100);
+  summary.p99Ms = percentileLocked((count_ * 99 + 99) / 100);
+  summary.maxMs = max_ms_;
+  return summary;
+}
+
+size_t LatencyHistogram::bucketOf(int64_t latency_ms) {
+  if (latency_ms < 100) {
+    return static_cast<size_t>(latency_ms);
+  }
+  if (latency_ms < 1000) {
+    return static_cast<size_t>(100 + (latency_ms - 100) / 10);
+  }
+  if (latency_ms < 10000) {
+    return static_cast<size_t>(190 + (latency_ms - 1000) / 100);
+  }
+  return kBucketCount - 1;
+}
+
+int64_t LatencyHistogram::lowerBoundOf(size_t bucket) {
+  if (bucket < 100) {
+    return static_cast<int64_t>(bucket);
+  }
+  if (bucket < 190) {
+    return 100 + static_cast<int64_t>(bucket - 100) * 10;
+  }
+  return 1000 + static_cast<int64_t>(bucket - 190) * 100;
+}
+
+// Lower bound of the bucket holding the `rank`-th smallest sample, clamped to
+// the real maximum.
+int64_t LatencyHistogram::percentileLocked(int64_t rank) const {
+  int64_t seen = 0;
+  for (size_t bucket = 0; bucket < buckets_.size(); ++bucket) {
+    seen += buckets_[bucket];
+    if (seen >= rank) {
+      return std::min(lowerBoundOf(bucket), max_ms_);
+    }
+  }
+  return max_ms_;
+}
+}  // namespace strtc
@@ -0,0 +1,35 @@
+#ifndef STRTC_LATENCY_HISTOGRAM_H_
+#define STRTC_LATENCY_HISTOGRAM_H_
+
+#include <stdint.h>
+
+#include <mutex>
+#include <vector>
+
+#include "strtc_common_define.h"
+
+namespace strtc {
+// Thread safe millisecond histogram. Buckets are 1 ms wide below 100 ms,
+// 10 ms below 1 s and 100 ms below 10 s, larger values share the last one.
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+
+  void add(int64_t latency_ms);
+  void reset();
+  LatencySummary summary() const;
+
+ private:
+  static size_t bucketOf(int64_t latency_ms);
+  static int64_t lowerBoundOf(size_t bucket);
+  int64_t percentileLocked(int64_t rank) const;
+
+ private:
+  mutable std::mutex mutex_;
+  std::vector<int64_t> buckets_;
+  int64_t count_ = 0;
+  int64_t sum_ms_ = 0;
+  int64_t max_ms_ = 0;
+};
+}  // namespace strtc
+#endif  // STRTC_LATENCY_HISTOGRAM_H_
@@ -0,0 +1,393 @@
+#include "strtc_latency_probe.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "api/video_codecs/video_codec.h"
+#include "common_video/h264/h264_common.h"
+#include "rtc_base/time_utils.h"
+
+namespace strtc {
+// 49 bits of UTC milliseconds, 7 per byte, top bit always set.
+constexpr size_t kLatencyStampSize = 7;
+constexpr uint8_t kLatencyTrailerMagic[] = {'S', 'T', 'G', 'G'};
+constexpr size_t kLatencyTrailerSize =
+    kLatencyStampSize + sizeof(kLatencyTrailerMagic);
+// user_data_unregistered uuid_iso_iec_11578 of the H.264 SEI.
+constexpr uint8_t kLatencySeiUuid[16] = {'S', 'T', 'R', 'T', 'C', '-',
+                                         'L', 'A', 'T', 'E', 'N', 'C',
+                                         'Y', '-', 'V', '1'};
+// nal_unit_type 6, payloadType 5 (user_data_unregistered), payloadSize.
+constexpr uint8_t kLatencySeiHeader[] = {
+    webrtc::H264::kSei, 5, sizeof(kLatencySeiUuid) + kLatencyStampSize};
+// Start code, header, uuid, stamp and rbsp_trailing_bits. No byte but the
+// start code is zero, so it never needs emulation prevention.
+constexpr size_t kLatencySeiSize =
+    webrtc::H264::kNaluLongStartSequenceSize + sizeof(kLatencySeiHeader) +
+    sizeof(kLatencySeiUuid) + kLatencyStampSize + 1;
+// About two seconds of frames.
+constexpr size_t kMaxTrackedFrames = 64;
+constexpr size_t kMaxCalibrationFrames = 16;
+
+namespace {
+rtc::scoped_refptr<webrtc::TransformedFrameCallback> CallbackFor(
+    uint32_t ssrc,
+    const rtc::scoped_refptr<webrtc::TransformedFrameCallback>& callback,
+    const std::map<uint32_t,
+                   rtc::scoped_refptr<webrtc::TransformedFrameCallback>>&
+        sink_callbacks) {
+  auto it = sink_callbacks.find(ssrc);
+  return it != sink_callbacks.end() ? it->second : callback;
+}
+
+std::map<uint8_t, webrtc::VideoCodecType> CodecTypes(
+    const std::vector<webrtc::RtpCodecParameters>& codecs) {
+  std::map<uint8_t, webrtc::VideoCodecType> types;
+  for (const auto& codec : codecs) {
+    types[static_cast<uint8_t>(codec.payload_type)] =
+        webrtc::PayloadStringToCodecType(codec.name);
+  }
+  return types;
+}
+
+void WriteStamp(int64_t utc_ms, uint8_t* stamp) {
+  for (size_t i = 0; i < kLatencyStampSize; ++i) {
+    int shift = static_cast<int>(7 * (kLatencyStampSize - 1 - i));
+    stamp[i] = 0x80 | ((static_cast<uint64_t>(utc_ms) >> shift) & 0x7f);
+  }
+}
+
+bool ReadStamp(const uint8_t* stamp, int64_t* utc_ms) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < kLatencyStampSize; ++i) {
+    if (!(stamp[i] & 0x80)) {
+      return false;
+    }
+    value = (value << 7) | (stamp[i] & 0x7f);
+  }
+  *utc_ms = static_cast<int64_t>(value);
+  return true;
+}
+
+bool IsSlice(uint8_t nalu_header) {
+  uint8_t type = nalu_header & 0x1f;
+  return type >= webrtc::H264::kSlice && type <= webrtc::H264::kIdr;
+}
+
+// Annex-B access unit with the stamp SEI in front of the first slice. False
+// if there is no slice.
+bool InsertSei(rtc::ArrayView<const uint8_t> data, int64_t utc_ms,
+               std::vector<uint8_t>* stamped) {
+  for (const auto& nalu :
+       webrtc::H264::FindNaluIndices(data.data(), data.size())) {
+    if (nalu.payload_size == 0 ||
+        !IsSlice(data[nalu.payload_start_offset])) {
+      continue;
+    }
+    uint8_t sei[kLatencySeiSize] = {0, 0, 0, 1};
+    uint8_t* it = sei + webrtc::H264::kNaluLongStartSequenceSize;
+    it = std::copy(std::begin(kLatencySeiHeader), std::end(kLatencySeiHeader),
+                   it);
+    it = std::copy(std::begin(kLatencySeiUuid), std::end(kLatencySeiUuid), it);
+    WriteStamp(utc_ms, it);
+    it[kLatencyStampSize] = 0x80;
+
+    stamped->reserve(data.size() + kLatencySeiSize);
+    stamped->assign(data.begin(), data.begin() + nalu.start_offset);
+    stamped->insert(stamped->end(), std::begin(sei), std::end(sei));
+    stamped->insert(stamped->end(), data.begin() + nalu.start_offset,
+                    data.end());
+    return true;
+  }
+  return false;
+}
+
+// Removes the stamp SEI InsertSei() added. False if there is none.
+bool StripSei(rtc::ArrayView<const uint8_t> data, int64_t* utc_ms,
+              std::vector<uint8_t>* payload) {
+  for (const auto& nalu :
+       webrtc::H264::FindNaluIndices(data.data(), data.size())) {
+    const uint8_t* sei = data.data() + nalu.payload_start_offset;
+    if (nalu.payload_size != kLatencySeiSize -
+                                 webrtc::H264::kNaluLongStartSequenceSize ||
+        !std::equal(std::begin(kLatencySeiHeader),
+                    std::end(kLatencySeiHeader), sei) ||
+        !std::equal(std::begin(kLatencySeiUuid), std::end(kLatencySeiUuid),
+                    sei + sizeof(kLatencySeiHeader)) ||
+        !ReadStamp(sei + sizeof(kLatencySeiHeader) + sizeof(kLatencySeiUuid),
+                   utc_ms)) {
+      continue;
+    }
+    size_t end = nalu.payload_start_offset + nalu.payload_size;
+    payload->reserve(data.size() - (end - nalu.start_offset));
+    payload->assign(data.begin(), data.begin() + nalu.start_offset);
+    payload->insert(payload->end(), data.begin() + end, data.end());
+    return true;
+  }
+  return false;
+}
+
+std::vector<uint8_t> AppendTrailer(rtc::ArrayView<const uint8_t> data,
+                                   int64_t utc_ms) {
+  std::vector<uint8_t> stamped(data.size() + kLatencyTrailerSize);
+  std::copy(data.begin(), data.end(), stamped.begin());
+  uint8_t* trailer = stamped.data() + data.size();
+  WriteStamp(utc_ms, trailer);
+  std::copy(std::begin(kLatencyTrailerMagic), std::end(kLatencyTrailerMagic),
+            trailer + kLatencyStampSize);
+  return stamped;
+}
+
+// Removes the trailer AppendTrailer() added. False if there is none.
+bool StripTrailer(rtc::ArrayView<const uint8_t> data, int64_t* utc_ms,
+                  std::vector<uint8_t>* payload) {
+  if (data.size() < kLatencyTrailerSize ||
+      !std::equal(std::begin(kLatencyTrailerMagic),
+                  std::end(kLatencyTrailerMagic),
+                  data.end() - sizeof(kLatencyTrailerMagic)) ||
+      !ReadStamp(data.data() + data.size() - kLatencyTrailerSize, utc_ms)) {
+    return false;
+  }
+  payload->assign(data.begin(), data.end() - kLatencyTrailerSize);
+  return true;
+}
+}  // namespace
+
+void LatencyStamper::SetCodecs(
+    const std::vector<webrtc::RtpCodecParameters>& codecs) {
+  std::map<uint8_t, webrtc::VideoCodecType> types = CodecTypes(codecs);
+  std::lock_guard<std::mutex> lock(mutex_);
+  codecs_ = std::move(types);
+}
+
+void LatencyStamper::OnFrame(const webrtc::VideoFrame& frame) {
+  // Same arithmetic as the encoder: 90 * capture ms, wrapping at 32 bits.
+  uint32_t rtp = static_cast<uint32_t>(frame.timestamp_us() /
+                                       rtc::kNumMicrosecsPerMillisec) *
+                 90u;
+  std::lock_guard<std::mutex> lock(mutex_);
+  captures_.push_back({rtp, rtc::TimeUTCMillis()});
+  if (captures_.size() > kMaxTrackedFrames) {
+    captures_.pop_front();
+  }
+}
+
+void LatencyStamper::Transform(
+    std::unique_ptr<webrtc::TransformableFrameInterface> frame) {
+  uint32_t rtp = frame->GetTimestamp();
+  int64_t utc_ms = 0;
+  webrtc::VideoCodecType codec = webrtc::kVideoCodecGeneric;
+  rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = codecs_.find(frame->GetPayloadType());
+    if (it != codecs_.end()) {
+      codec = it->second;
+    }
+    if (!FindCaptureLocked(rtp, &utc_ms)) {
+      CalibrateLocked(rtp);
+      if (!FindCaptureLocked(rtp, &utc_ms)) {
+        // Nothing captured yet, the encode time is the closest we have.
+        utc_ms = rtc::TimeUTCMillis();
+      }
+    }
+    transformed_.push_back(rtp);
+    if (transformed_.size() > kMaxCalibrationFrames) {
+      transformed_.pop_front();
+    }
+    callback = CallbackFor(frame->GetSsrc(), callback_, sink_callbacks_);
+  }
+  if (!callback) {
+    return;
+  }
+
+  rtc::ArrayView<const uint8_t> data = frame->GetData();
+  std::vector<uint8_t> stamped;
+  if (codec == webrtc::kVideoCodecH264) {
+    if (InsertSei(data, utc_ms, &stamped)) {
+      frame->SetData(stamped);
+    }
+  } else if (codec == webrtc::kVideoCodecVP8) {
+    frame->SetData(AppendTrailer(data, utc_ms));
+  }
+  callback->OnTransformedFrame(std::move(frame));
+}
+
+bool LatencyStamper::FindCaptureLocked(uint32_t rtp, int64_t* utc_ms) {
+  if (!calibrated_) {
+    return false;
+  }
+  uint32_t capture_rtp = rtp - rtp_offset_;
+  for (auto it = captures_.rbegin(); it != captures_.rend(); ++it) {
+    if (it->rtp == capture_rtp) {
+      *utc_ms = it->utc_ms;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Tries every tracked capture as the one `rtp` belongs to and keeps the
+// offset that also explains most of the previously transformed frames.
+// Capture intervals jitter by a millisecond or more, so a wrong offset
+// rarely lines up with more than one frame.
+void LatencyStamper::CalibrateLocked(uint32_t rtp) {
+  int best_hits = -1;
+  for (auto capture = captures_.rbegin(); capture != captures_.rend();
+       ++capture) {
+    uint32_t offset = rtp - capture->rtp;
+    int hits = 0;
+    for (uint32_t transformed : transformed_) {
+      uint32_t capture_rtp = transformed - offset;
+      hits += std::any_of(captures_.begin(), captures_.end(),
+                          [capture_rtp](const Capture& c) {
+                            return c.rtp == capture_rtp;
+                          })
+                  ? 1
+                  : 0;
+    }
+    if (hits > best_hits) {
+      best_hits = hits;
+      rtp_offset_ = offset;
+      calibrated_ = true;
+    }
+  }
+}
+
+void LatencyStamper::RegisterTransformedFrameCallback(
+    rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  callback_ = callback;
+}
+
+void LatencyStamper::RegisterTransformedFrameSinkCallback(
+    rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback,
+    uint32_t ssrc) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  sink_callbacks_[ssrc] = callback;
+}
+
+void LatencyStamper::UnregisterTransformedFrameCallback() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  callback_ = nullptr;
+}
+
+void LatencyStamper::UnregisterTransformedFrameSinkCallback(uint32_t ssrc) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  sink_callbacks_.erase(ssrc);
+}
+
+LatencyReader::LatencyReader(int report_interval_ms, ReportCallback on_report)
+    : report_interval_ms_(report_interval_ms),
+      on_report_(std::move(on_report)) {}
+
+void LatencyReader::Stop() {
+  std::lock_guard<std::mutex> lock(report_mutex_);
+  on_report_ = nullptr;
+}
+
+void LatencyReader::SetCodecs(
+    const std::vector<webrtc::RtpCodecParameters>& codecs) {
+  std::map<uint8_t, webrtc::VideoCodecType> types = CodecTypes(codecs);
+  std::lock_guard<std::mutex> lock(mutex_);
+  codecs_ = std::move(types);
+}
+
+void LatencyReader::OnFrame(const webrtc::VideoFrame& frame) {
+  int64_t now_ms = rtc::TimeUTCMillis();
+  int64_t capture_ms = -1;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = captures_.begin(); it != captures_.end(); ++it) {
+      if (it->first == frame.timestamp()) {
+        capture_ms = it->second;
+        // Older ones were dropped before rendering.
+        captures_.erase(captures_.begin(), it + 1);
+        break;
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(report_mutex_);
+  if (capture_ms >= 0) {
+    histogram_.add(std::max<int64_t>(0, now_ms - capture_ms));
+  }
+  if (last_report_ms_ == 0) {
+    last_report_ms_ = now_ms;
+  }
+  if (now_ms - last_report_ms_ < report_interval_ms_) {
+    return;
+  }
+  last_report_ms_ = now_ms;
+  LatencySummary summary = histogram_.summary();
+  histogram_.reset();
+  if (on_report_ && summary.count > 0) {
+    on_report_(summary);
+  }
+}
+
+void LatencyReader::Transform(
+    std::unique_ptr<webrtc::TransformableFrameInterface> frame) {
+  webrtc::VideoCodecType codec = webrtc::kVideoCodecGeneric;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = codecs_.find(frame->GetPayloadType());
+    if (it != codecs_.end()) {
+      codec = it->second;
+    }
+  }
+
+  rtc::ArrayView<const uint8_t> data = frame->GetData();
+  int64_t utc_ms = 0;
+  std::vector<uint8_t> payload;
+  bool stamped = false;
+  if (codec == webrtc::kVideoCodecH264) {
+    stamped = StripSei(data, &utc_ms, &payload);
+  } else if (codec == webrtc::kVideoCodecVP8) {
+    stamped = StripTrailer(data, &utc_ms, &payload);
+  }
+
+  rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stamped) {
+      captures_.emplace_back(frame->GetTimestamp(), utc_ms);
+      if (captures_.size() > kMaxTrackedFrames) {
+        captures_.pop_front();
+      }
+    }
+    callback = CallbackFor(frame->GetSsrc(), callback_, sink_callbacks_);
+  }
+  if (!callback) {
+    return;
+  }
+  if (stamped) {
+    // The decoder must never see the stamp.
+    frame->SetData(payload);
+  }
+  callback->OnTransformedFrame(std::move(frame));
+}
+
+void LatencyReader::RegisterTransformedFrameCallback(
+    rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  callback_ = callback;
+}
+
+void LatencyReader::RegisterTransformedFrameSinkCallback(
+    rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback,
+    uint32_t ssrc) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  sink_callbacks_[ssrc] = callback;
+}
+
+void LatencyReader::UnregisterTransformedFrameCallback() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  callback_ = nullptr;
+}
+
+void LatencyReader::UnregisterTransformedFrameSinkCallback(uint32_t ssrc) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  sink_callbacks_.erase(ssrc);
+}
+}  // namespace strtc
@@ -0,0 +1,136 @@
+#ifndef STRTC_LATENCY_PROBE_H_
+#define STRTC_LATENCY_PROBE_H_
+
+#include <stdint.h>
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "api/frame_transformer_interface.h"
+#include "api/rtp_parameters.h"
+#include "api/video/video_codec_type.h"
+#include "api/video/video_frame.h"
+#include "api/video/video_sink_interface.h"
+#include "strtc_latency_histogram.h"
+
+namespace strtc {
+// Glass-to-glass latency probe. The publisher stamps the capture wall
+// clock time into every encoded video frame, the subscriber strips it again
+// before decoding and measures capture -> render per frame. The stamp
+// travels in the payload, so SRS forwards it untouched. Both sides need the
+// same wall clock: one host, or hosts synchronized by NTP/PTP.
+//
+// The stamp is UTC milliseconds in 7 bit groups with the top bit set, so it
+// never holds a zero byte and can never form an Annex-B start code. Where it
+// goes depends on the codec of the frame's payload type, see SetCodecs():
+// - H.264: an SEI user_data_unregistered NAL before the first slice. Every
+//   decoder and the SRS RTMP bridge skip it.
+// - VP8: a trailer behind the last partition, followed by a magic. VP8
+//   decoders stop reading before it.
+// - Anything else is left alone: VP9 and AV1 keep their own data at the end
+//   of the frame.
+
+// Publisher half. Added as a sink to the local video track to see capture
+// times, and set as the video sender's encoder-to-packetizer transformer.
+// Encoded frames only carry an RTP timestamp, which is 90 * capture ms plus
+// a constant of the sender; the constant is learned from the captured
+// frames and re-learned on a miss.
+class LatencyStamper : public webrtc::FrameTransformerInterface,
+                       public rtc::VideoSinkInterface<webrtc::VideoFrame> {
+ public:
+  // The negotiated send codecs. Frames are not stamped before this is set.
+  void SetCodecs(const std::vector<webrtc::RtpCodecParameters>& codecs);
+
+  // rtc::VideoSinkInterface, called by the capturer.
+  void OnFrame(const webrtc::VideoFrame& frame) override;
+
+  // webrtc::FrameTransformerInterface
+  void Transform(
+      std::unique_ptr<webrtc::TransformableFrameInterface> frame) override;
+  void RegisterTransformedFrameCallback(
+      rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback) override;
+  void RegisterTransformedFrameSinkCallback(
+      rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback,
+      uint32_t ssrc) override;
+  void UnregisterTransformedFrameCallback() override;
+  void UnregisterTransformedFrameSinkCallback(uint32_t ssrc) override;
+
+ private:
+  struct Capture {
+    // 90 kHz capture time, without the sender's constant.
+    uint32_t rtp;
+    int64_t utc_ms;
+  };
+
+  bool FindCaptureLocked(uint32_t rtp, int64_t* utc_ms);
+  void CalibrateLocked(uint32_t rtp);
+
+ private:
+  std::mutex mutex_;
+  std::deque<Capture> captures_;
+  // RTP timestamps of the last transformed frames, to check a calibration
+  // against.
+  std::deque<uint32_t> transformed_;
+  uint32_t rtp_offset_ = 0;
+  bool calibrated_ = false;
+  // Payload type -> codec.
+  std::map<uint8_t, webrtc::VideoCodecType> codecs_;
+
+  rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback_;
+  std::map<uint32_t, rtc::scoped_refptr<webrtc::TransformedFrameCallback>>
+      sink_callbacks_;
+};
+
+// Subscriber half. Set as the video receiver's depacketizer-to-decoder
+// transformer and added as a sink to the remote video track. Every
+// `report_interval_ms` the latency percentiles of the frames rendered
+// since the previous report go to `on_report`, on the decoding thread.
+class LatencyReader : public webrtc::FrameTransformerInterface,
+                      public rtc::VideoSinkInterface<webrtc::VideoFrame> {
+ public:
+  using ReportCallback = std::function<void(const LatencySummary& summary)>;
+
+  LatencyReader(int report_interval_ms, ReportCallback on_report);
+
+  // Stops the reports, the callback is not running once it returns.
+  void Stop();
+  // The negotiated receive codecs. Frames pass through untouched before
+  // this is set.
+  void SetCodecs(const std::vector<webrtc::RtpCodecParameters>& codecs);
+
+  // rtc::VideoSinkInterface, called with the decoded frames.
+  void OnFrame(const webrtc::VideoFrame& frame) override;
+
+  // webrtc::FrameTransformerInterface
+  void Transform(
+      std::unique_ptr<webrtc::TransformableFrameInterface> frame) override;
+  void RegisterTransformedFrameCallback(
+      rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback) override;
+  void RegisterTransformedFrameSinkCallback(
+      rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback,
+      uint32_t ssrc) override;
+  void UnregisterTransformedFrameCallback() override;
+  void UnregisterTransformedFrameSinkCallback(uint32_t ssrc) override;
+
+ private:
+  const int report_interval_ms_;
+
+  std::mutex mutex_;
+  // RTP timestamp -> capture UTC ms, of frames not rendered yet.
+  std::deque<std::pair<uint32_t, int64_t>> captures_;
+  std::map<uint8_t, webrtc::VideoCodecType> codecs_;
+  rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback_;
+  std::map<uint32_t, rtc::scoped_refptr<webrtc::TransformedFrameCallback>>
+      sink_callbacks_;
+
+  // Held while reporting.
+  std::mutex report_mutex_;
+  ReportCallback on_report_;
+  LatencyHistogram histogram_;
+  int64_t last_report_ms_ = 0;
+};
+}  // namespace strtc
+#endif  // STRTC_LATENCY_PROBE_H_
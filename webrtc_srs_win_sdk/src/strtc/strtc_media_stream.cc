@@ -1,5 +1,7 @@
 #include "strtc_media_stream.h"
 
+#include <algorithm>
+
 #include "api/audio_codecs/audio_decoder_factory.h"
 #include "api/audio_codecs/audio_encoder_factory.h"
 #include "api/audio_codecs/builtin_audio_decoder_factory.h"
@@ -11,52 +13,134 @@
 #include "api/video_codecs/video_decoder_factory.h"
 #include "api/video_codecs/video_encoder_factory.h"
 #include "modules/audio_device/include/audio_device.h"
-#include "modules/video_capture/video_capture_factory.h"
 #include "pc/video_track_source.h"
 #include "rtc_base/logging.h"
 #include "rtc_base/ref_counted_object.h"
+#include "strtc_frame_generator_capturer.h"
+#include "strtc_screen_capturer.h"
 #include "strtc_vcm_capturer.h"
+#include "strtc_video_device_registry.h"
 
 namespace strtc {
 class CapturerTrackSource : public webrtc::VideoTrackSource {
  public:
-  static rtc::scoped_refptr<CapturerTrackSource> Create(int width, int height,
-                                                        int fps) {
-    std::unique_ptr<strtc::VcmCapturer> capturer;
-    std::unique_ptr<webrtc::VideoCaptureModule::DeviceInfo> info(
-        webrtc::VideoCaptureFactory::CreateDeviceInfo());
-    if (!info) {
-      return nullptr;
+  // `device_id` empty opens the device that delivers the request at the
+  // lowest cost, the others are only tried if it fails to open.
+  static rtc::scoped_refptr<CapturerTrackSource> Create(
+      int width, int height, int fps, const std::string& device_id) {
+    VideoDeviceRegistry* registry = VideoDeviceRegistry::Instance();
+    std::vector<VideoDevice> devices;
+    if (!device_id.empty()) {
+      VideoDevice device;
+      if (!registry->GetDevice(device_id, &device)) {
+        RTC_LOG(LS_ERROR) << __FUNCTION__ << " no video device " << device_id;
+        return nullptr;
+      }
+      devices.push_back(device);
+    } else {
+      devices = RankDevices(registry->GetDevices(), width, height, fps);
     }
-    int num_devices = info->NumberOfDevices();
-    for (int i = 0; i < num_devices; ++i) {
-      capturer =
-          absl::WrapUnique(strtc::VcmCapturer::Create(width, height, fps, i));
+
+    for (const auto& device : devices) {
+      std::unique_ptr<strtc::VcmCapturer> capturer = absl::WrapUnique(
+          strtc::VcmCapturer::Create(width, height, fps, device));
       if (capturer) {
-        return rtc::make_ref_counted<CapturerTrackSource>(std::move(capturer));
+        CaptureFormat format = capturer->capture_format();
+        rtc::scoped_refptr<CapturerTrackSource> source =
+            rtc::make_ref_counted<CapturerTrackSource>(std::move(capturer));
+        source->capture_format_ = format;
+        return source;
       }
     }
 
     return nullptr;
   }
 
+  static rtc::scoped_refptr<CapturerTrackSource> CreateGenerator(
+      int width, int height, int fps, const std::string& file) {
+    std::unique_ptr<FrameGeneratorCapturer> capturer =
+        FrameGeneratorCapturer::Create(width, height, fps, file);
+    if (!capturer) {
+      return nullptr;
+    }
+    return rtc::make_ref_counted<CapturerTrackSource>(std::move(capturer));
+  }
+
+  // A screen, or with `window` set a window.
+  static rtc::scoped_refptr<CapturerTrackSource> CreateScreen(
+      int fps, int64_t source_id, bool window) {
+    if (window && source_id < 0) {
+      RTC_LOG(LS_ERROR) << __FUNCTION__ << " no window selected";
+      return nullptr;
+    }
+    std::unique_ptr<ScreenCapturer> capturer = ScreenCapturer::Create(
+        fps,
+        source_id < 0 ? webrtc::kFullDesktopScreenId
+                      : static_cast<webrtc::DesktopCapturer::SourceId>(
+                            source_id),
+        window);
+    if (!capturer) {
+      return nullptr;
+    }
+    return rtc::make_ref_counted<CapturerTrackSource>(std::move(capturer),
+                                                      /*screencast=*/true);
+  }
+
+  bool is_screencast() const override { return screencast_; }
+
+  // The camera mode in use, empty for screen and generated sources.
+  const absl::optional<CaptureFormat>& capture_format() const {
+    return capture_format_;
+  }
+
  protected:
-  explicit CapturerTrackSource(std::unique_ptr<strtc::VcmCapturer> capturer)
-      : VideoTrackSource(/*remote=*/false), capturer_(std::move(capturer)) {}
+  explicit CapturerTrackSource(
+      std::unique_ptr<webrtc::test::TestVideoCapturer> capturer,
+      bool screencast = false)
+      : VideoTrackSource(/*remote=*/false),
+        capturer_(std::move(capturer)),
+        screencast_(screencast) {}
 
  private:
+  // Devices that deliver the request in full first, then by the total cost
+  // of their best mode. Devices without known modes go last.
+  static std::vector<VideoDevice> RankDevices(std::vector<VideoDevice> devices,
+                                              int width, int height, int fps) {
+    auto rank = [width, height, fps](const VideoDevice& device) {
+      CaptureFormat format;
+      if (!VcmCapturer::SelectCaptureFormat(device.capabilities, width, height,
+                                            fps, &format)) {
+        return std::make_pair(2, int64_t{0});
+      }
+      return std::make_pair(format.degraded ? 1 : 0, format.total_cost);
+    };
+    std::stable_sort(devices.begin(), devices.end(),
+                     [&rank](const VideoDevice& a, const VideoDevice& b) {
+                       return rank(a) < rank(b);
+                     });
+    return devices;
+  }
+
   rtc::VideoSourceInterface<webrtc::VideoFrame>* source() override {
     return capturer_.get();
   }
 
  private:
-  std::unique_ptr<strtc::VcmCapturer> capturer_;
+  std::unique_ptr<webrtc::test::TestVideoCapturer> capturer_;
+  const bool screencast_;
+  absl::optional<CaptureFormat> capture_format_;
 };
 
 StrtcMediaStream::StrtcMediaStream(
     rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory,
     StreamOptions& options)
     : factory_(factory),
+      stream_type_(options.streamType),
+      generator_file_(options.generatorFile),
+      video_device_id_(options.videoDeviceId),
+      content_hint_(options.contentHint),
+      screen_source_id_(options.screenSourceId),
+      window_source_id_(options.windowSourceId),
       has_audio_(options.hasAudio),
       has_video_(options.hasVideo),
       width_(options.width),
@@ -89,10 +173,23 @@ bool StrtcMediaStream::startStream() {
   }
 
   if (has_video_) {
-    video_device_ = CapturerTrackSource::Create(width_, height_, fps_);
+    if (stream_type_ == STRREAM_TYPE_GENERATOR) {
+      video_device_ = CapturerTrackSource::CreateGenerator(
+          width_, height_, fps_, generator_file_);
+    } else if (stream_type_ == STRREAM_TYPE_SCREEN) {
+      video_device_ =
+          CapturerTrackSource::CreateScreen(fps_, screen_source_id_, false);
+    } else if (stream_type_ == STRREAM_TYPE_WINDOW) {
+      video_device_ =
+          CapturerTrackSource::CreateScreen(fps_, window_source_id_, true);
+    } else {
+      video_device_ = CapturerTrackSource::Create(width_, height_, fps_,
+                                                  video_device_id_);
+    }
     if (video_device_) {
       rtc::scoped_refptr<webrtc::VideoTrackInterface> video_track(
           factory_->CreateVideoTrack("STONEvideo", video_device_.get()));
+      video_track->set_content_hint(contentHint());
       media_stream_->AddTrack(video_track);
     } else {
       RTC_LOG(LS_ERROR) << __FUNCTION__ << " create capturer source failed";
@@ -105,20 +202,96 @@ bool StrtcMediaStream::startStream() {
   return true;
 }
 
+webrtc::VideoTrackInterface::ContentHint StrtcMediaStream::contentHint()
+    const {
+  switch (content_hint_) {
+    case CONTENT_HINT_FLUID:
+      return webrtc::VideoTrackInterface::ContentHint::kFluid;
+    case CONTENT_HINT_DETAILED:
+      return webrtc::VideoTrackInterface::ContentHint::kDetailed;
+    case CONTENT_HINT_TEXT:
+      return webrtc::VideoTrackInterface::ContentHint::kText;
+    default:
+      break;
+  }
+  // Screen content is mostly static, keep it sharp.
+  return stream_type_ == STRREAM_TYPE_SCREEN ||
+                 stream_type_ == STRREAM_TYPE_WINDOW
+             ? webrtc::VideoTrackInterface::ContentHint::kDetailed
+             : webrtc::VideoTrackInterface::ContentHint::kNone;
+}
+
 void StrtcMediaStream::setVideoRender(HWND wnd) {
   if (media_stream_) {
-    video_renderer_ = std::make_unique<VideoRenderer>(wnd);
     auto videoTracks = media_stream_->GetVideoTracks();
+    if (video_renderer_) {
+      video_renderer_->SetWantsCallback(nullptr);
+      for (auto track : videoTracks) {
+        track->RemoveSink(video_renderer_.get());
+      }
+    }
+    video_renderer_ = std::make_unique<VideoRenderer>(wnd);
+    VideoRenderer* renderer = video_renderer_.get();
     for (auto track : videoTracks) {
-      track->AddOrUpdateSink(video_renderer_.get(), rtc::VideoSinkWants());
+      track->AddOrUpdateSink(renderer, rtc::VideoSinkWants());
+    }
+    // The capturer's single VideoAdapter also feeds the encoder and the
+    // broadcaster applies the smallest wants of all sinks, so the preview
+    // must not cap resolution or frame rate. It leaves the track while the
+    // window is hidden instead.
+    renderer->SetWantsCallback(
+        [videoTracks, renderer](const rtc::VideoSinkWants& wants) {
+          for (auto track : videoTracks) {
+            if (wants.max_framerate_fps == 0) {
+              track->RemoveSink(renderer);
+            } else {
+              track->AddOrUpdateSink(renderer, rtc::VideoSinkWants());
+            }
+          }
+        });
+  }
+}
+void StrtcMediaStream::addVideoSink(
+    rtc::VideoSinkInterface<webrtc::VideoFrame>* sink) {
+  if (!media_stream_ || !sink) {
+    return;
+  }
+  for (auto track : media_stream_->GetVideoTracks()) {
+    track->AddOrUpdateSink(sink, rtc::VideoSinkWants());
+  }
+  if (std::find(video_sinks_.begin(), video_sinks_.end(), sink) ==
+      video_sinks_.end()) {
+    video_sinks_.push_back(sink);
+  }
+}
+
+void StrtcMediaStream::removeVideoSink(
+    rtc::VideoSinkInterface<webrtc::VideoFrame>* sink) {
+  auto it = std::find(video_sinks_.begin(), video_sinks_.end(), sink);
+  if (it == video_sinks_.end()) {
+    return;
+  }
+  video_sinks_.erase(it);
+  if (media_stream_) {
+    for (auto track : media_stream_->GetVideoTracks()) {
+      track->RemoveSink(sink);
     }
   }
 }
+
 rtc::scoped_refptr<webrtc::MediaStreamInterface>
 StrtcMediaStream::getMediaStream() {
   return media_stream_;
 }
 
+bool StrtcMediaStream::getCaptureFormat(CaptureFormat* format) const {
+  if (!video_device_ || !video_device_->capture_format()) {
+    return false;
+  }
+  *format = *video_device_->capture_format();
+  return true;
+}
+
 void StrtcMediaStream::stopStream() {
   if (media_stream_) {
     auto audioTracks = media_stream_->GetAudioTracks();
@@ -126,12 +299,19 @@ void StrtcMediaStream::stopStream() {
       media_stream_->RemoveTrack(track);
     }
     auto videoTracks = media_stream_->GetVideoTracks();
+    if (video_renderer_) {
+      video_renderer_->SetWantsCallback(nullptr);
+    }
     for (auto track : videoTracks) {
       if (video_renderer_) {
         track->RemoveSink(video_renderer_.get());
       }
+      for (auto sink : video_sinks_) {
+        track->RemoveSink(sink);
+      }
       media_stream_->RemoveTrack(track);
     }
   }
+  video_sinks_.clear();
 }
 }  // namespace strtc
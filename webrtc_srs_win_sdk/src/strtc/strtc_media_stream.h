@@ -8,6 +8,7 @@
 
 namespace strtc {
 class CapturerTrackSource;
+struct CaptureFormat;
 class StrtcMediaStream {
  public:
   StrtcMediaStream(
@@ -19,9 +20,25 @@ class StrtcMediaStream {
   void stopStream();
 
   void setVideoRender(HWND wnd);
+  // Extra sinks for the captured video, not owned. Removed from the tracks
+  // again in stopStream().
+  void addVideoSink(rtc::VideoSinkInterface<webrtc::VideoFrame>* sink);
+  void removeVideoSink(rtc::VideoSinkInterface<webrtc::VideoFrame>* sink);
   rtc::scoped_refptr<webrtc::MediaStreamInterface> getMediaStream();
+  // The camera mode picked for the stream, false for screen and generated
+  // video.
+  bool getCaptureFormat(CaptureFormat* format) const;
 
  private:
+  webrtc::VideoTrackInterface::ContentHint contentHint() const;
+
+ private:
+  StreamType stream_type_;
+  std::string generator_file_;
+  std::string video_device_id_;
+  ContentHint content_hint_;
+  int64_t screen_source_id_;
+  int64_t window_source_id_;
   bool has_audio_;
   bool has_video_;
   int width_;
@@ -33,6 +50,7 @@ class StrtcMediaStream {
   rtc::scoped_refptr<webrtc::MediaStreamInterface> media_stream_;
 
   std::unique_ptr<VideoRenderer> video_renderer_;
+  std::vector<rtc::VideoSinkInterface<webrtc::VideoFrame>*> video_sinks_;
 };
 }  // namespace strtc
 
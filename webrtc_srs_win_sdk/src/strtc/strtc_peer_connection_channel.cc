@@ -1,13 +1,23 @@
 #include "strtc_peer_connection_channel.h"
 
+#include <algorithm>
+#include <limits>
+
+#include "absl/strings/match.h"
 #include "modules/audio_device/include/audio_device.h"
 #include "modules/video_capture/video_capture_factory.h"
 #include "pc/video_track_source.h"
+#include "rtc_base/task_utils/to_queued_task.h"
 #include "rtc_base/thread.h"
-#include "strtc_srs_signal.h"
+#include "rtc_base/time_utils.h"
+#include "strtc_signal.h"
 #include "strtc_video_render.h"
 
 namespace strtc {
+// Latency percentiles cover this many milliseconds of rendered frames.
+constexpr int kLatencyReportIntervalMs = 5000;
+// Largest kbps value whose bps still fits RtpEncodingParameters' int.
+constexpr int kMaxBitrateKbps = std::numeric_limits<int>::max() / 1000;
 class DummySetSessionDescriptionObserver
     : public webrtc::SetSessionDescriptionObserver {
  public:
@@ -45,33 +55,64 @@ StrtcPeerConnectionChannel::StrtcPeerConnectionChannel(
     rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory,
     rtc::scoped_refptr<webrtc::MediaStreamInterface> media_stream,
     ChannelType channel_type, int channel_id,
-    StrtcPeerConnectionChannelObserver* observer)
+    StrtcPeerConnectionChannelObserver* observer,
+    rtc::Thread* signaling_thread, HttpRequestLoop* http_loop,
+    const ChannelOptions& options)
     : factory_(factory),
       media_stream_(media_stream),
       channel_type_(channel_type),
       channel_id_(channel_id),
-      observer_(observer) {
-  srs_signaling_.reset(new StrtcSrsSignal());
-}
+      options_(options),
+      signaling_thread_(signaling_thread),
+      http_loop_(http_loop),
+      observer_(observer) {}
 
 StrtcPeerConnectionChannel::~StrtcPeerConnectionChannel() {
   RTC_LOG(LS_INFO) << __FUNCTION__;
-  if (peer_connection_) {
-    std::vector<rtc::scoped_refptr<webrtc::RtpSenderInterface>> senders =
-        peer_connection_->GetSenders();
-    for (const auto& sender : senders) {
-      peer_connection_->RemoveTrack(sender);
+  closePeerConnection();
+}
+
+webrtc::PeerConnectionInterface::RTCConfiguration
+StrtcPeerConnectionChannel::createConfiguration(const IceOptions& ice) {
+  webrtc::PeerConnectionInterface::RTCConfiguration config;
+  config.sdp_semantics = webrtc::SdpSemantics::kUnifiedPlan;
+  if (!ice.hostOnly) {
+    for (const auto& ice_server : ice.servers) {
+      webrtc::PeerConnectionInterface::IceServer server;
+      server.urls = ice_server.urls;
+      server.username = ice_server.username;
+      server.password = ice_server.password;
+      config.servers.push_back(server);
     }
-    peer_connection_->Close();
   }
+  config.tcp_candidate_policy =
+      ice.tcpCandidates
+          ? webrtc::PeerConnectionInterface::kTcpCandidatePolicyEnabled
+          : webrtc::PeerConnectionInterface::kTcpCandidatePolicyDisabled;
+  config.ice_candidate_pool_size = ice.candidatePoolSize;
+  config.continual_gathering_policy =
+      ice.continualGathering
+          ? webrtc::PeerConnectionInterface::GATHER_CONTINUALLY
+          : webrtc::PeerConnectionInterface::GATHER_ONCE;
+  config.disable_link_local_networks = true;
+  return config;
+}
+
+void StrtcPeerConnectionChannel::adoptPeerConnection(
+    PooledPeerConnection pooled) {
+  pooled_observer_ = std::move(pooled.observer);
+  pooled_observer_->setTarget(this);
+  peer_connection_ = pooled.peer_connection;
 }
 
 void StrtcPeerConnectionChannel::start(
     const std::string& url, std::function<void()> on_success,
     std::function<void(std::string error)> on_failure) {
   url_ = url;
+  start_ms_ = rtc::TimeMillis();
   on_success_ = on_success;
   on_failure_ = on_failure;
+  signaling_ = StrtcSignal::Create(url_, http_loop_);
   if (!createPeerConnection()) {
     if (on_failure_) {
       std::string error("create peer connection failed");
@@ -82,22 +123,221 @@ void StrtcPeerConnectionChannel::start(
   }
 }
 
-void StrtcPeerConnectionChannel::stop() {}
+void StrtcPeerConnectionChannel::stop(std::function<void()> on_stopped) {
+  if (signaling_) {
+    signaling_->close();
+  }
 
-void StrtcPeerConnectionChannel::setRemoteVideoRender(HWND wnd) {
-  video_renderer_.reset(new VideoRenderer(wnd));
-  std::vector<rtc::scoped_refptr<webrtc::RtpReceiverInterface>> receiver =
-      peer_connection_->GetReceivers();
-  if (video_renderer_.get()) {
-    for (int index = 0; index < receiver.size(); index++) {
-      auto* track = reinterpret_cast<webrtc::MediaStreamTrackInterface*>(
-          (void*)receiver[index]->track());
-      if (track->kind() == webrtc::MediaStreamTrackInterface::kVideoKind) {
-        auto* video_track = static_cast<webrtc::VideoTrackInterface*>(track);
-        video_track->AddOrUpdateSink(video_renderer_.get(),
-                                     rtc::VideoSinkWants());
+  // Close() blocks until transports and decoders are gone, keep it off the
+  // engine thread. The task holds a reference so the channel outlives it.
+  rtc::scoped_refptr<StrtcPeerConnectionChannel> self(this);
+  auto close = [self, on_stopped]() {
+    self->on_success_ = nullptr;
+    self->on_failure_ = nullptr;
+    self->closePeerConnection();
+    if (on_stopped) {
+      on_stopped();
+    }
+  };
+  if (!signaling_thread_ || signaling_thread_->IsCurrent()) {
+    close();
+    return;
+  }
+  signaling_thread_->PostTask(webrtc::ToQueuedTask(std::move(close)));
+}
+
+void StrtcPeerConnectionChannel::closePeerConnection() {
+  if (peer_connection_) {
+    // Detach the render sinks first so no frame reaches a dying renderer.
+    if (video_renderer_) {
+      video_renderer_->SetWantsCallback(nullptr);
+    }
+    for (const auto& track : remoteVideoTracks()) {
+      if (video_renderer_) {
+        track->RemoveSink(video_renderer_.get());
+      }
+      for (const auto& sink : remote_video_sinks_) {
+        track->RemoveSink(sink.first);
+      }
+      if (latency_reader_) {
+        track->RemoveSink(latency_reader_.get());
       }
     }
+    if (latency_reader_) {
+      latency_reader_->Stop();
+    }
+    if (latency_stamper_ && media_stream_) {
+      for (const auto& track : media_stream_->GetVideoTracks()) {
+        track->RemoveSink(latency_stamper_.get());
+      }
+    }
+
+    std::vector<rtc::scoped_refptr<webrtc::RtpSenderInterface>> senders =
+        peer_connection_->GetSenders();
+    for (const auto& sender : senders) {
+      peer_connection_->RemoveTrack(sender);
+    }
+    peer_connection_->Close();
+    peer_connection_ = nullptr;
+  }
+  if (pooled_observer_) {
+    pooled_observer_->setTarget(nullptr);
+  }
+  video_renderer_.reset();
+  remote_video_sinks_.clear();
+}
+
+bool StrtcPeerConnectionChannel::getStats(
+    rtc::scoped_refptr<webrtc::RTCStatsCollectorCallback> callback) {
+  if (!peer_connection_) {
+    return false;
+  }
+  peer_connection_->GetStats(callback.get());
+  return true;
+}
+
+std::vector<rtc::scoped_refptr<webrtc::VideoTrackInterface>>
+StrtcPeerConnectionChannel::remoteVideoTracks() {
+  std::vector<rtc::scoped_refptr<webrtc::VideoTrackInterface>> tracks;
+  if (!peer_connection_) {
+    return tracks;
+  }
+  for (const auto& receiver : peer_connection_->GetReceivers()) {
+    rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> track =
+        receiver->track();
+    if (track &&
+        track->kind() == webrtc::MediaStreamTrackInterface::kVideoKind) {
+      tracks.push_back(static_cast<webrtc::VideoTrackInterface*>(track.get()));
+    }
+  }
+  return tracks;
+}
+
+void StrtcPeerConnectionChannel::attachRemoteVideoSinks() {
+  std::vector<rtc::scoped_refptr<webrtc::VideoTrackInterface>> tracks =
+      remoteVideoTracks();
+  attachRenderer(tracks);
+  for (const auto& track : tracks) {
+    for (const auto& sink : remote_video_sinks_) {
+      track->AddOrUpdateSink(sink.first, sink.second);
+    }
+  }
+}
+
+void StrtcPeerConnectionChannel::attachLatencyReader() {
+  if (!options_.measureLatency || latency_reader_) {
+    return;
+  }
+  StrtcPeerConnectionChannelObserver* observer = observer_;
+  int channel_id = channel_id_;
+  latency_reader_ = rtc::make_ref_counted<LatencyReader>(
+      kLatencyReportIntervalMs,
+      [observer, channel_id](const LatencySummary& latency) {
+        if (observer) {
+          observer->on_latency(channel_id, latency);
+        }
+      });
+  for (const auto& receiver : peer_connection_->GetReceivers()) {
+    if (receiver->media_type() != cricket::MediaType::MEDIA_TYPE_VIDEO) {
+      continue;
+    }
+    // Before any frame arrives, so none reaches the decoder with a trailer.
+    receiver->SetDepacketizerToDecoderFrameTransformer(latency_reader_);
+  }
+  for (const auto& track : remoteVideoTracks()) {
+    track->AddOrUpdateSink(latency_reader_.get(), rtc::VideoSinkWants());
+  }
+}
+
+void StrtcPeerConnectionChannel::updateLatencyCodecs() {
+  if (!peer_connection_ || (!latency_stamper_ && !latency_reader_)) {
+    return;
+  }
+  std::vector<webrtc::RtpCodecParameters> send_codecs;
+  for (const auto& sender : peer_connection_->GetSenders()) {
+    if (sender->media_type() == cricket::MediaType::MEDIA_TYPE_VIDEO) {
+      std::vector<webrtc::RtpCodecParameters> codecs =
+          sender->GetParameters().codecs;
+      send_codecs.insert(send_codecs.end(), codecs.begin(), codecs.end());
+    }
+  }
+  std::vector<webrtc::RtpCodecParameters> receive_codecs;
+  for (const auto& receiver : peer_connection_->GetReceivers()) {
+    if (receiver->media_type() == cricket::MediaType::MEDIA_TYPE_VIDEO) {
+      std::vector<webrtc::RtpCodecParameters> codecs =
+          receiver->GetParameters().codecs;
+      receive_codecs.insert(receive_codecs.end(), codecs.begin(),
+                            codecs.end());
+    }
+  }
+  if (latency_stamper_) {
+    latency_stamper_->SetCodecs(send_codecs);
+  }
+  if (latency_reader_) {
+    latency_reader_->SetCodecs(receive_codecs);
+  }
+}
+
+void StrtcPeerConnectionChannel::attachRenderer(
+    const std::vector<rtc::scoped_refptr<webrtc::VideoTrackInterface>>&
+        tracks) {
+  if (!video_renderer_) {
+    return;
+  }
+  VideoRenderer* renderer = video_renderer_.get();
+  for (const auto& track : tracks) {
+    track->AddOrUpdateSink(renderer, renderer->GetWants());
+  }
+  // Runs on the render thread, cleared before the renderer is detached.
+  renderer->SetWantsCallback(
+      [tracks, renderer](const rtc::VideoSinkWants& wants) {
+        for (const auto& track : tracks) {
+          track->AddOrUpdateSink(renderer, wants);
+        }
+      });
+}
+
+ChannelSetupTimings StrtcPeerConnectionChannel::getSetupTimings() {
+  ChannelSetupTimings timings;
+  timings.createOfferMs = offer_ms_ - start_ms_;
+  timings.signalingMs = answer_ms_ - offer_ms_;
+  timings.setRemoteMs = remote_ms_ - answer_ms_;
+  timings.totalMs = remote_ms_ - start_ms_;
+  return timings;
+}
+
+void StrtcPeerConnectionChannel::setRemoteVideoRender(HWND wnd) {
+  std::vector<rtc::scoped_refptr<webrtc::VideoTrackInterface>> tracks =
+      remoteVideoTracks();
+  if (video_renderer_) {
+    video_renderer_->SetWantsCallback(nullptr);
+    for (const auto& track : tracks) {
+      track->RemoveSink(video_renderer_.get());
+    }
+  }
+  video_renderer_.reset(new VideoRenderer(wnd));
+  attachRenderer(tracks);
+}
+
+void StrtcPeerConnectionChannel::addRemoteVideoSink(
+    rtc::VideoSinkInterface<webrtc::VideoFrame>* sink,
+    const rtc::VideoSinkWants& wants) {
+  if (!sink) {
+    return;
+  }
+  for (const auto& track : remoteVideoTracks()) {
+    track->AddOrUpdateSink(sink, wants);
+  }
+  remote_video_sinks_[sink] = wants;
+}
+
+void StrtcPeerConnectionChannel::removeRemoteVideoSink(
+    rtc::VideoSinkInterface<webrtc::VideoFrame>* sink) {
+  if (remote_video_sinks_.erase(sink) == 0) {
+    return;
+  }
+  for (const auto& track : remoteVideoTracks()) {
+    track->RemoveSink(sink);
   }
 }
 
@@ -107,12 +347,17 @@ bool StrtcPeerConnectionChannel::createPeerConnection() {
     return false;
   }
 
-  webrtc::PeerConnectionInterface::RTCConfiguration config;
-  config.sdp_semantics = webrtc::SdpSemantics::kUnifiedPlan;
-  webrtc::PeerConnectionInterface::IceServer server;
-  server.uri = "stun:stun.l.google.com:19302";
-  config.servers.push_back(server);
-  config.disable_link_local_networks = true;
+  // A pooled PeerConnection already has its transceivers.
+  if (peer_connection_) {
+    attachRemoteVideoSinks();
+    attachLatencyReader();
+    applyCodecPreferences();
+    createOffer();
+    return true;
+  }
+
+  webrtc::PeerConnectionInterface::RTCConfiguration config =
+      createConfiguration(options_.ice);
   auto error_or_peer_connection = factory_->CreatePeerConnectionOrError(
       config, webrtc::PeerConnectionDependencies(this));
   if (error_or_peer_connection.ok()) {
@@ -130,7 +375,16 @@ bool StrtcPeerConnectionChannel::createPeerConnection() {
         peer_connection_->AddTrack(audioTrack, {});
       }
       for (const auto& videoTrack : media_stream_->GetVideoTracks()) {
-        peer_connection_->AddTrack(videoTrack, {});
+        rtc::scoped_refptr<webrtc::RtpSenderInterface> sender =
+            addVideoTrack(videoTrack);
+        if (options_.measureLatency && sender) {
+          if (!latency_stamper_) {
+            latency_stamper_ = rtc::make_ref_counted<LatencyStamper>();
+          }
+          videoTrack->AddOrUpdateSink(latency_stamper_.get(),
+                                      rtc::VideoSinkWants());
+          sender->SetEncoderToPacketizerFrameTransformer(latency_stamper_);
+        }
       }
     }
   } else if (channel_type_ == ChannelType::SUBSCRIBE) {
@@ -140,13 +394,194 @@ bool StrtcPeerConnectionChannel::createPeerConnection() {
                                      init);
     peer_connection_->AddTransceiver(cricket::MediaType::MEDIA_TYPE_VIDEO,
                                      init);
+    // Sinks set before start() were waiting for the receive tracks.
+    attachRemoteVideoSinks();
+    attachLatencyReader();
   }
+  applyCodecPreferences();
 
   createOffer();
 
   return true;
 }
 
+rtc::scoped_refptr<webrtc::RtpSenderInterface>
+StrtcPeerConnectionChannel::addVideoTrack(
+    rtc::scoped_refptr<webrtc::VideoTrackInterface> track) {
+  if (options_.simulcast.empty()) {
+    auto sender = peer_connection_->AddTrack(track, {});
+    return sender.ok() ? sender.MoveValue() : nullptr;
+  }
+
+  // One encoding per layer, all fed by the same track.
+  webrtc::RtpTransceiverInit init;
+  init.direction = webrtc::RtpTransceiverDirection::kSendOnly;
+  init.stream_ids.push_back(media_stream_->id());
+  for (const auto& layer : options_.simulcast) {
+    webrtc::RtpEncodingParameters encoding;
+    encoding.rid = layer.rid;
+    encoding.scale_resolution_down_by = std::max(1.0, layer.scaleDownBy);
+    if (layer.maxBitrateKbps > 0) {
+      // Anything above is no limit in practice.
+      encoding.max_bitrate_bps =
+          std::min(layer.maxBitrateKbps, kMaxBitrateKbps) * 1000;
+    }
+    if (layer.maxFramerate > 0) {
+      encoding.max_framerate = layer.maxFramerate;
+    }
+    init.send_encodings.push_back(encoding);
+  }
+  auto transceiver = peer_connection_->AddTransceiver(track, init);
+  if (!transceiver.ok()) {
+    RTC_LOG(LS_ERROR) << __FUNCTION__ << " simulcast: "
+                      << transceiver.error().message();
+    return nullptr;
+  }
+  return transceiver.value()->sender();
+}
+
+bool StrtcPeerConnectionChannel::updateVideoSendParameters(
+    const std::function<void(webrtc::RtpParameters* parameters)>& update) {
+  if (!peer_connection_) {
+    return false;
+  }
+  bool updated = false;
+  for (const auto& sender : peer_connection_->GetSenders()) {
+    if (sender->media_type() != cricket::MediaType::MEDIA_TYPE_VIDEO) {
+      continue;
+    }
+    // GetParameters() hands out the transaction id SetParameters() checks.
+    webrtc::RtpParameters parameters = sender->GetParameters();
+    update(&parameters);
+    webrtc::RTCError error = sender->SetParameters(parameters);
+    if (!error.ok()) {
+      RTC_LOG(LS_WARNING) << __FUNCTION__ << " " << error.message();
+      continue;
+    }
+    updated = true;
+  }
+  return updated;
+}
+
+bool StrtcPeerConnectionChannel::setSimulcastLayerActive(
+    const std::string& rid, bool active) {
+  bool found = false;
+  bool updated =
+      updateVideoSendParameters([&](webrtc::RtpParameters* parameters) {
+        for (auto& encoding : parameters->encodings) {
+          if (encoding.rid == rid) {
+            encoding.active = active;
+            found = true;
+          }
+        }
+      });
+  return updated && found;
+}
+
+bool StrtcPeerConnectionChannel::setEncoderParameters(
+    const EncoderParameters& parameters) {
+  if (parameters.maxBitrateKbps > kMaxBitrateKbps ||
+      parameters.minBitrateKbps > kMaxBitrateKbps) {
+    RTC_LOG(LS_ERROR) << __FUNCTION__ << " bitrate out of range, max: "
+                      << parameters.maxBitrateKbps
+                      << " min: " << parameters.minBitrateKbps;
+    return false;
+  }
+  bool found = false;
+  bool updated =
+      updateVideoSendParameters([&](webrtc::RtpParameters* rtp_parameters) {
+        bool matched = false;
+        for (auto& encoding : rtp_parameters->encodings) {
+          if (!parameters.rid.empty() && encoding.rid != parameters.rid) {
+            continue;
+          }
+          matched = true;
+          if (parameters.maxBitrateKbps == 0) {
+            encoding.max_bitrate_bps.reset();
+          } else if (parameters.maxBitrateKbps > 0) {
+            encoding.max_bitrate_bps = parameters.maxBitrateKbps * 1000;
+          }
+          if (parameters.minBitrateKbps == 0) {
+            encoding.min_bitrate_bps.reset();
+          } else if (parameters.minBitrateKbps > 0) {
+            encoding.min_bitrate_bps = parameters.minBitrateKbps * 1000;
+          }
+          if (parameters.maxFramerate == 0) {
+            encoding.max_framerate.reset();
+          } else if (parameters.maxFramerate > 0) {
+            encoding.max_framerate = parameters.maxFramerate;
+          }
+          if (parameters.scaleDownBy > 0) {
+            encoding.scale_resolution_down_by =
+                std::max(1.0, parameters.scaleDownBy);
+          }
+        }
+        // An unknown rid leaves the sender alone.
+        if (!matched) {
+          return;
+        }
+        found = true;
+        switch (parameters.degradation) {
+          case DEGRADATION_MAINTAIN_FRAMERATE:
+            rtp_parameters->degradation_preference =
+                webrtc::DegradationPreference::MAINTAIN_FRAMERATE;
+            break;
+          case DEGRADATION_MAINTAIN_RESOLUTION:
+            rtp_parameters->degradation_preference =
+                webrtc::DegradationPreference::MAINTAIN_RESOLUTION;
+            break;
+          case DEGRADATION_BALANCED:
+            rtp_parameters->degradation_preference =
+                webrtc::DegradationPreference::BALANCED;
+            break;
+          case DEGRADATION_DISABLED:
+            rtp_parameters->degradation_preference =
+                webrtc::DegradationPreference::DISABLED;
+            break;
+          default:
+            break;
+        }
+      });
+  return updated && found;
+}
+
+void StrtcPeerConnectionChannel::applyCodecPreferences() {
+  if (options_.videoCodecs.empty()) {
+    return;
+  }
+  webrtc::RtpCapabilities capabilities =
+      channel_type_ == ChannelType::PUBLISH
+          ? factory_->GetRtpSenderCapabilities(
+                cricket::MediaType::MEDIA_TYPE_VIDEO)
+          : factory_->GetRtpReceiverCapabilities(
+                cricket::MediaType::MEDIA_TYPE_VIDEO);
+  // Preferred codecs first, the rest (rtx, red, ulpfec too) keep their
+  // order behind them.
+  std::vector<webrtc::RtpCodecCapability> codecs;
+  for (const auto& name : options_.videoCodecs) {
+    for (const auto& codec : capabilities.codecs) {
+      if (absl::EqualsIgnoreCase(codec.name, name)) {
+        codecs.push_back(codec);
+      }
+    }
+  }
+  for (const auto& codec : capabilities.codecs) {
+    if (std::find(codecs.begin(), codecs.end(), codec) == codecs.end()) {
+      codecs.push_back(codec);
+    }
+  }
+
+  for (const auto& transceiver : peer_connection_->GetTransceivers()) {
+    if (transceiver->media_type() != cricket::MediaType::MEDIA_TYPE_VIDEO) {
+      continue;
+    }
+    webrtc::RTCError error = transceiver->SetCodecPreferences(codecs);
+    if (!error.ok()) {
+      RTC_LOG(LS_WARNING) << __FUNCTION__ << " " << error.message();
+    }
+  }
+}
+
 void StrtcPeerConnectionChannel::createOffer() {
   webrtc::PeerConnectionInterface::RTCOfferAnswerOptions options;
   options.offer_to_receive_audio = true;
@@ -160,8 +595,25 @@ void StrtcPeerConnectionChannel::createAnswer() {
 }
 
 void StrtcPeerConnectionChannel::sendOffer(const std::string& offer) {
-  std::string answer;
-  if (srs_signaling_->post(url_, offer, &answer, channel_type_) == 0) {
+  // The answer is applied back on the signaling thread, the http request
+  // itself never blocks it.
+  rtc::Thread* signaling_thread = rtc::Thread::Current();
+  rtc::scoped_refptr<StrtcPeerConnectionChannel> self(this);
+  signaling_->postAsync(
+      url_, offer, channel_type_,
+      [self, signaling_thread](int code, const std::string& answer) {
+        if (!signaling_thread || signaling_thread->IsCurrent()) {
+          self->onAnswer(code, answer);
+          return;
+        }
+        signaling_thread->PostTask(webrtc::ToQueuedTask(
+            [self, code, answer]() { self->onAnswer(code, answer); }));
+      });
+}
+
+void StrtcPeerConnectionChannel::onAnswer(int code, const std::string& answer) {
+  answer_ms_ = rtc::TimeMillis();
+  if (code == 0 && peer_connection_) {
     RTC_LOG(LS_INFO) << __FUNCTION__ << " " << answer;
     webrtc::SdpParseError error;
     std::unique_ptr<webrtc::SessionDescriptionInterface> desc =
@@ -188,6 +640,7 @@ void StrtcPeerConnectionChannel::sendOffer(const std::string& offer) {
 
 void StrtcPeerConnectionChannel::OnSuccess(
     webrtc::SessionDescriptionInterface* desc) {
+  offer_ms_ = rtc::TimeMillis();
   if (peer_connection_) {
     peer_connection_->SetLocalDescription(
         DummySetSessionDescriptionObserver::Create(
@@ -231,6 +684,10 @@ void StrtcPeerConnectionChannel::OnSetLocalSessionDescriptionFailure(
 
 void StrtcPeerConnectionChannel::OnSetRemoteSessionDescriptionSuccess() {
   RTC_LOG(LS_ERROR) << __FUNCTION__;
+  remote_ms_ = rtc::TimeMillis();
+  // The payload types are known once the answer is applied, before any
+  // media flows.
+  updateLatencyCodecs();
   if (on_success_) {
     on_success_();
     on_success_ = nullptr;
@@ -289,11 +746,21 @@ void StrtcPeerConnectionChannel::OnIceConnectionChange(
 }
 
 void StrtcPeerConnectionChannel::OnIceGatheringChange(
-    webrtc::PeerConnectionInterface::IceGatheringState new_state) {}
+    webrtc::PeerConnectionInterface::IceGatheringState new_state) {
+  if (signaling_ &&
+      new_state == webrtc::PeerConnectionInterface::kIceGatheringComplete) {
+    signaling_->endOfCandidates();
+  }
+}
 
 void StrtcPeerConnectionChannel::OnIceCandidate(
     const webrtc::IceCandidateInterface* candidate) {
   RTC_LOG(LS_INFO) << __FUNCTION__;
+  std::string sdp;
+  if (signaling_ && candidate->ToString(&sdp)) {
+    signaling_->addCandidate(candidate->sdp_mid(), candidate->sdp_mline_index(),
+                             sdp);
+  }
 }
 
 void StrtcPeerConnectionChannel::OnIceConnectionReceivingChange(
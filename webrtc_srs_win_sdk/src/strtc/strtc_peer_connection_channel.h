@@ -1,9 +1,15 @@
 #ifndef STRTC_PEER_CONNECTION_CHANNEL_H_
 #define STRTC_PEER_CONNECTION_CHANNEL_H_
 
+#include <map>
+
 #include "api/peer_connection_interface.h"
+#include "rtc_base/thread.h"
 #include "strtc_common_define.h"
-#include "strtc_srs_signal.h"
+#include "strtc_latency_probe.h"
+#include "strtc_peer_connection_pool.h"
+#include "strtc_signal.h"
+#include "strtc_video_render.h"
 
 namespace strtc {
 class StrtcPeerConnectionChannelObserver {
@@ -11,6 +17,8 @@ class StrtcPeerConnectionChannelObserver {
   virtual ~StrtcPeerConnectionChannelObserver() = default;
   virtual void on_stream_failure(int channel_id, int code,
                                  std::string& error) = 0;
+  // ChannelOptions::measureLatency, on the decoding thread.
+  virtual void on_latency(int channel_id, const LatencySummary& latency) {}
 };
 
 class StrtcPeerConnectionChannel
@@ -21,23 +29,69 @@ class StrtcPeerConnectionChannel
       rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory,
       rtc::scoped_refptr<webrtc::MediaStreamInterface> media_stream,
       ChannelType channel_type, int channel_id,
-      StrtcPeerConnectionChannelObserver* observer);
+      StrtcPeerConnectionChannelObserver* observer,
+      rtc::Thread* signaling_thread, HttpRequestLoop* http_loop = nullptr,
+      const ChannelOptions& options = ChannelOptions());
 
   ~StrtcPeerConnectionChannel();
 
+  static webrtc::PeerConnectionInterface::RTCConfiguration
+  createConfiguration(const IceOptions& ice);
+
+  // Uses a pre-created PeerConnection instead of building one in start().
+  // Must be called before start().
+  void adoptPeerConnection(PooledPeerConnection pooled);
+
   void start(const std::string& url, std::function<void()> on_success,
              std::function<void(std::string error)> on_failure);
-  void stop();
+  // Releases the server session and closes the PeerConnection on the
+  // signaling thread. `on_stopped` runs there once everything is released.
+  void stop(std::function<void()> on_stopped);
   void setRemoteVideoRender(HWND wnd);
+  // Extra sinks for the remote video, not owned. Adding a sink again
+  // updates its wants. Once removeRemoteVideoSink() returns the sink gets no
+  // more frames.
+  void addRemoteVideoSink(
+      rtc::VideoSinkInterface<webrtc::VideoFrame>* sink,
+      const rtc::VideoSinkWants& wants = rtc::VideoSinkWants());
+  void removeRemoteVideoSink(rtc::VideoSinkInterface<webrtc::VideoFrame>* sink);
 
   ChannelType getChannelType() { return channel_type_; }
+  // Asks the PeerConnection for an RTCStatsReport, delivered to `callback`
+  // on the signaling thread. False before start() and after stop().
+  bool getStats(
+      rtc::scoped_refptr<webrtc::RTCStatsCollectorCallback> callback);
+  // Pauses or resumes the ChannelOptions::simulcast layer `rid`. False if
+  // there is no such layer.
+  bool setSimulcastLayerActive(const std::string& rid, bool active);
+  bool setEncoderParameters(const EncoderParameters& parameters);
+  // Valid once the start succeeded. queueMs is left to the caller.
+  ChannelSetupTimings getSetupTimings();
 
  private:
   bool createPeerConnection();
+  void closePeerConnection();
+  std::vector<rtc::scoped_refptr<webrtc::VideoTrackInterface>>
+  remoteVideoTracks();
+  void attachRemoteVideoSinks();
+  void attachLatencyReader();
+  // Tells the latency probe which payload types carry which codec.
+  void updateLatencyCodecs();
+  void applyCodecPreferences();
+  // AddTrack(), or AddTransceiver() with one encoding per simulcast layer.
+  rtc::scoped_refptr<webrtc::RtpSenderInterface> addVideoTrack(
+      rtc::scoped_refptr<webrtc::VideoTrackInterface> track);
+  // Get, update and set the RtpParameters of every video sender.
+  bool updateVideoSendParameters(
+      const std::function<void(webrtc::RtpParameters* parameters)>& update);
+  void attachRenderer(
+      const std::vector<rtc::scoped_refptr<webrtc::VideoTrackInterface>>&
+          tracks);
   void createOffer();
   void createAnswer();
 
   void sendOffer(const std::string& message);
+  void onAnswer(int code, const std::string& answer);
 
   // PeerConnectionObserver implementation
   void OnSignalingChange(
@@ -75,17 +129,31 @@ class StrtcPeerConnectionChannel
  private:
   rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory_;
 
+  std::unique_ptr<ForwardingPeerConnectionObserver> pooled_observer_;
   rtc::scoped_refptr<webrtc::PeerConnectionInterface> peer_connection_;
   rtc::scoped_refptr<webrtc::MediaStreamInterface> media_stream_;
-  std::unique_ptr<rtc::VideoSinkInterface<webrtc::VideoFrame>> video_renderer_;
+  std::unique_ptr<VideoRenderer> video_renderer_;
+  std::map<rtc::VideoSinkInterface<webrtc::VideoFrame>*, rtc::VideoSinkWants>
+      remote_video_sinks_;
+  // ChannelOptions::measureLatency, publish and subscribe half.
+  rtc::scoped_refptr<LatencyStamper> latency_stamper_;
+  rtc::scoped_refptr<LatencyReader> latency_reader_;
 
   ChannelType channel_type_;
   int channel_id_;
+  ChannelOptions options_;
   std::string url_;
-  std::unique_ptr<StrtcSrsSignal> srs_signaling_;
+  rtc::Thread* signaling_thread_;
+  HttpRequestLoop* http_loop_;
+  std::unique_ptr<StrtcSignal> signaling_;
 
   StrtcPeerConnectionChannelObserver* observer_;
 
+  int64_t start_ms_ = 0;
+  int64_t offer_ms_ = 0;
+  int64_t answer_ms_ = 0;
+  int64_t remote_ms_ = 0;
+
   std::function<void()> on_success_;
   std::function<void(std::string error)> on_failure_;
 };
@@ -0,0 +1,173 @@
+#include "strtc_peer_connection_pool.h"
+
+#include <algorithm>
+
+#include "rtc_base/logging.h"
+#include "rtc_base/task_utils/to_queued_task.h"
+#include "strtc_peer_connection_channel.h"
+
+namespace strtc {
+void ForwardingPeerConnectionObserver::setTarget(
+    webrtc::PeerConnectionObserver* target) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  target_ = target;
+}
+
+webrtc::PeerConnectionObserver* ForwardingPeerConnectionObserver::target() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return target_;
+}
+
+void ForwardingPeerConnectionObserver::OnSignalingChange(
+    webrtc::PeerConnectionInterface::SignalingState new_state) {
+  if (auto* observer = target()) {
+    observer->OnSignalingChange(new_state);
+  }
+}
+
+void ForwardingPeerConnectionObserver::OnAddStream(
+    rtc::scoped_refptr<webrtc::MediaStreamInterface> stream) {
+  if (auto* observer = target()) {
+    observer->OnAddStream(stream);
+  }
+}
+
+void ForwardingPeerConnectionObserver::OnRemoveStream(
+    rtc::scoped_refptr<webrtc::MediaStreamInterface> stream) {
+  if (auto* observer = target()) {
+    observer->OnRemoveStream(stream);
+  }
+}
+
+void ForwardingPeerConnectionObserver::OnAddTrack(
+    rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver,
+    const std::vector<rtc::scoped_refptr<webrtc::MediaStreamInterface>>&
+        streams) {
+  if (auto* observer = target()) {
+    observer->OnAddTrack(receiver, streams);
+  }
+}
+
+void ForwardingPeerConnectionObserver::OnRemoveTrack(
+    rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver) {
+  if (auto* observer = target()) {
+    observer->OnRemoveTrack(receiver);
+  }
+}
+
+void ForwardingPeerConnectionObserver::OnDataChannel(
+    rtc::scoped_refptr<webrtc::DataChannelInterface> channel) {
+  if (auto* observer = target()) {
+    observer->OnDataChannel(channel);
+  }
+}
+
+void ForwardingPeerConnectionObserver::OnRenegotiationNeeded() {
+  if (auto* observer = target()) {
+    observer->OnRenegotiationNeeded();
+  }
+}
+
+void ForwardingPeerConnectionObserver::OnIceConnectionChange(
+    webrtc::PeerConnectionInterface::IceConnectionState new_state) {
+  if (auto* observer = target()) {
+    observer->OnIceConnectionChange(new_state);
+  }
+}
+
+void ForwardingPeerConnectionObserver::OnIceGatheringChange(
+    webrtc::PeerConnectionInterface::IceGatheringState new_state) {
+  if (auto* observer = target()) {
+    observer->OnIceGatheringChange(new_state);
+  }
+}
+
+void ForwardingPeerConnectionObserver::OnIceCandidate(
+    const webrtc::IceCandidateInterface* candidate) {
+  if (auto* observer = target()) {
+    observer->OnIceCandidate(candidate);
+  }
+}
+
+void ForwardingPeerConnectionObserver::OnIceConnectionReceivingChange(
+    bool receiving) {
+  if (auto* observer = target()) {
+    observer->OnIceConnectionReceivingChange(receiving);
+  }
+}
+
+void ForwardingPeerConnectionObserver::OnConnectionChange(
+    webrtc::PeerConnectionInterface::PeerConnectionState new_state) {
+  if (auto* observer = target()) {
+    observer->OnConnectionChange(new_state);
+  }
+}
+
+StrtcPeerConnectionPool::StrtcPeerConnectionPool(
+    rtc::Thread* thread,
+    rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory,
+    const IceOptions& ice, size_t size)
+    : thread_(thread), factory_(factory), ice_(ice), size_(size) {}
+
+StrtcPeerConnectionPool::~StrtcPeerConnectionPool() {
+  for (auto& pooled : pool_) {
+    pooled.peer_connection->Close();
+  }
+}
+
+void StrtcPeerConnectionPool::fill() {
+  RTC_DCHECK(thread_->IsCurrent());
+  if (filling_ || pool_.size() >= size_) {
+    return;
+  }
+
+  // One PeerConnection per task, channel starts queued meanwhile get a turn.
+  filling_ = true;
+  thread_->PostTask(webrtc::ToQueuedTask([this]() {
+    filling_ = false;
+    PooledPeerConnection pooled;
+    if (!create(&pooled)) {
+      RTC_LOG(LS_WARNING) << __FUNCTION__ << " create pooled pc failed";
+      return;
+    }
+    pool_.push_back(std::move(pooled));
+    fill();
+  }));
+}
+
+bool StrtcPeerConnectionPool::take(PooledPeerConnection* pooled) {
+  RTC_DCHECK(thread_->IsCurrent());
+  if (pool_.empty()) {
+    fill();
+    return false;
+  }
+  *pooled = std::move(pool_.front());
+  pool_.pop_front();
+  RTC_LOG(LS_INFO) << __FUNCTION__ << " " << pool_.size() << " left";
+  fill();
+  return true;
+}
+
+bool StrtcPeerConnectionPool::create(PooledPeerConnection* pooled) {
+  webrtc::PeerConnectionInterface::RTCConfiguration config =
+      StrtcPeerConnectionChannel::createConfiguration(ice_);
+  // Starts gathering right away instead of after SetLocalDescription.
+  config.ice_candidate_pool_size = std::max(config.ice_candidate_pool_size, 1);
+
+  pooled->observer = std::make_unique<ForwardingPeerConnectionObserver>();
+  auto error_or_peer_connection = factory_->CreatePeerConnectionOrError(
+      config, webrtc::PeerConnectionDependencies(pooled->observer.get()));
+  if (!error_or_peer_connection.ok()) {
+    return false;
+  }
+  pooled->peer_connection = std::move(error_or_peer_connection.value());
+
+  webrtc::RtpTransceiverInit init;
+  init.direction = webrtc::RtpTransceiverDirection::kRecvOnly;
+  pooled->peer_connection->AddTransceiver(cricket::MediaType::MEDIA_TYPE_AUDIO,
+                                          init);
+  pooled->peer_connection->AddTransceiver(cricket::MediaType::MEDIA_TYPE_VIDEO,
+                                          init);
+  return true;
+}
+}  // namespace strtc
@@ -0,0 +1,85 @@
+#ifndef STRTC_PEER_CONNECTION_POOL_H_
+#define STRTC_PEER_CONNECTION_POOL_H_
+
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include "api/peer_connection_interface.h"
+#include "rtc_base/thread.h"
+#include "strtc_common_define.h"
+
+namespace strtc {
+// A pooled PeerConnection is created before its channel exists, so its
+// observer forwards to whichever channel adopts it. Events before adoption
+// are dropped.
+class ForwardingPeerConnectionObserver : public webrtc::PeerConnectionObserver {
+ public:
+  void setTarget(webrtc::PeerConnectionObserver* target);
+
+  void OnSignalingChange(
+      webrtc::PeerConnectionInterface::SignalingState new_state) override;
+  void OnAddStream(
+      rtc::scoped_refptr<webrtc::MediaStreamInterface> stream) override;
+  void OnRemoveStream(
+      rtc::scoped_refptr<webrtc::MediaStreamInterface> stream) override;
+  void OnAddTrack(
+      rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver,
+      const std::vector<rtc::scoped_refptr<webrtc::MediaStreamInterface>>&
+          streams) override;
+  void OnRemoveTrack(
+      rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver) override;
+  void OnDataChannel(
+      rtc::scoped_refptr<webrtc::DataChannelInterface> channel) override;
+  void OnRenegotiationNeeded() override;
+  void OnIceConnectionChange(
+      webrtc::PeerConnectionInterface::IceConnectionState new_state) override;
+  void OnIceGatheringChange(
+      webrtc::PeerConnectionInterface::IceGatheringState new_state) override;
+  void OnIceCandidate(const webrtc::IceCandidateInterface* candidate) override;
+  void OnIceConnectionReceivingChange(bool receiving) override;
+  void OnConnectionChange(
+      webrtc::PeerConnectionInterface::PeerConnectionState new_state) override;
+
+ private:
+  webrtc::PeerConnectionObserver* target();
+
+ private:
+  std::mutex mutex_;
+  webrtc::PeerConnectionObserver* target_ = nullptr;
+};
+
+struct PooledPeerConnection {
+  rtc::scoped_refptr<webrtc::PeerConnectionInterface> peer_connection;
+  std::unique_ptr<ForwardingPeerConnectionObserver> observer;
+};
+
+// Keeps recv-only PeerConnections with their audio/video transceivers
+// added and ICE candidates pre-gathered, so a subscribe channel only has to
+// run the offer/answer exchange. Must be used on `thread`.
+class StrtcPeerConnectionPool {
+ public:
+  StrtcPeerConnectionPool(
+      rtc::Thread* thread,
+      rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory,
+      const IceOptions& ice, size_t size);
+  ~StrtcPeerConnectionPool();
+
+  // Creates PeerConnections until the pool is full, one per posted task.
+  void fill();
+  // Returns false when the pool is empty. Triggers a refill.
+  bool take(PooledPeerConnection* pooled);
+
+ private:
+  bool create(PooledPeerConnection* pooled);
+
+ private:
+  rtc::Thread* thread_;
+  rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory_;
+  IceOptions ice_;
+  size_t size_;
+  std::deque<PooledPeerConnection> pool_;
+  bool filling_ = false;
+};
+}  // namespace strtc
+#endif  // STRTC_PEER_CONNECTION_POOL_H_
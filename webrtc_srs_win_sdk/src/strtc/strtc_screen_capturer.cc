@@ -0,0 +1,218 @@
+#include "strtc_screen_capturer.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "modules/desktop_capture/desktop_capture_options.h"
+#include "modules/desktop_capture/desktop_frame.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/time_utils.h"
+#include "third_party/libyuv/include/libyuv/convert.h"
+
+namespace strtc {
+// Frames in flight to the encoder plus one being written.
+constexpr size_t kMaxPooledBuffers = 3;
+
+std::unique_ptr<ScreenCapturer> ScreenCapturer::Create(
+    int fps, webrtc::DesktopCapturer::SourceId source_id, bool window) {
+  std::unique_ptr<webrtc::DesktopCapturer> capturer =
+      CreatePlatformCapturer(window);
+  if (!capturer) {
+    return nullptr;
+  }
+  if (!capturer->SelectSource(source_id)) {
+    RTC_LOG(LS_ERROR) << __FUNCTION__ << " select "
+                      << (window ? "window " : "screen ") << source_id
+                      << " failed";
+    return nullptr;
+  }
+  return Create(fps, std::move(capturer));
+}
+
+bool ScreenCapturer::GetSources(bool window,
+                                webrtc::DesktopCapturer::SourceList* sources) {
+  std::unique_ptr<webrtc::DesktopCapturer> capturer =
+      CreatePlatformCapturer(window);
+  return capturer && capturer->GetSourceList(sources);
+}
+
+std::unique_ptr<webrtc::DesktopCapturer> ScreenCapturer::CreatePlatformCapturer(
+    bool window) {
+  webrtc::DesktopCaptureOptions options =
+      webrtc::DesktopCaptureOptions::CreateDefault();
+  // Capturers that cannot tell what changed get a differ wrapped around
+  // them.
+  options.set_detect_updated_region(true);
+  std::unique_ptr<webrtc::DesktopCapturer> capturer =
+      window ? webrtc::DesktopCapturer::CreateWindowCapturer(options)
+             : webrtc::DesktopCapturer::CreateScreenCapturer(options);
+  if (!capturer) {
+    RTC_LOG(LS_ERROR) << __FUNCTION__ << " create "
+                      << (window ? "window" : "screen") << " capturer failed";
+  }
+  return capturer;
+}
+
+std::unique_ptr<ScreenCapturer> ScreenCapturer::Create(
+    int fps, std::unique_ptr<webrtc::DesktopCapturer> capturer) {
+  if (fps <= 0 || !capturer) {
+    return nullptr;
+  }
+  return std::unique_ptr<ScreenCapturer>(
+      new ScreenCapturer(fps, std::move(capturer)));
+}
+
+ScreenCapturer::ScreenCapturer(
+    int fps, std::unique_ptr<webrtc::DesktopCapturer> capturer)
+    : fps_(fps),
+      capturer_(std::move(capturer)),
+      buffer_pool_(false, kMaxPooledBuffers) {
+  thread_ = std::thread([this]() { Run(); });
+}
+
+ScreenCapturer::~ScreenCapturer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+  }
+  cond_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  Stats stats = GetStats();
+  RTC_LOG(LS_INFO) << __FUNCTION__ << " captured: " << stats.captured
+                   << " unchanged: " << stats.unchanged
+                   << " delivered: " << stats.delivered;
+}
+
+ScreenCapturer::Stats ScreenCapturer::GetStats() {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  return stats_;
+}
+
+void ScreenCapturer::Run() {
+  capturer_->Start(this);
+
+  const std::chrono::microseconds interval(rtc::kNumMicrosecsPerSec / fps_);
+  auto next_capture = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!cond_.wait_until(lock, next_capture, [this]() { return stopped_; })) {
+    lock.unlock();
+    capturer_->CaptureFrame();
+    lock.lock();
+
+    next_capture += interval;
+    auto now = std::chrono::steady_clock::now();
+    if (next_capture < now) {
+      next_capture = now;
+    }
+  }
+
+  // Released on the thread it was used on.
+  capturer_.reset();
+  stale_regions_.clear();
+  buffer_pool_.Release();
+}
+
+void ScreenCapturer::OnCaptureResult(
+    webrtc::DesktopCapturer::Result result,
+    std::unique_ptr<webrtc::DesktopFrame> frame) {
+  if (result != webrtc::DesktopCapturer::Result::SUCCESS || !frame) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    ++stats_.captured;
+  }
+
+  const webrtc::DesktopSize& size = frame->size();
+  if (!size.equals(size_)) {
+    // Every pooled buffer has the old size, start over.
+    stale_regions_.clear();
+    buffer_pool_.Release();
+    size_ = size;
+  } else if (frame->updated_region().is_empty()) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    ++stats_.unchanged;
+    return;
+  }
+
+  webrtc::DesktopRect frame_rect = webrtc::DesktopRect::MakeSize(size);
+  webrtc::DesktopRegion updated(frame->updated_region());
+  updated.IntersectWith(frame_rect);
+  for (auto& it : stale_regions_) {
+    it.second.AddRegion(updated);
+  }
+
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      buffer_pool_.CreateI420Buffer(size.width(), size.height());
+  if (!buffer) {
+    // Every buffer is still held downstream.
+    return;
+  }
+  auto stale = stale_regions_.find(buffer.get());
+  if (stale == stale_regions_.end()) {
+    // Nothing written yet.
+    stale = stale_regions_
+                .emplace(buffer.get(), webrtc::DesktopRegion(frame_rect))
+                .first;
+  }
+  int64_t converted = Convert(*frame, stale->second, buffer.get());
+  stale->second.Clear();
+
+  webrtc::DesktopRect bounds = webrtc::DesktopRect::MakeSize(size);
+  webrtc::DesktopRegion::Iterator it(updated);
+  if (!it.IsAtEnd()) {
+    bounds = it.rect();
+    for (; !it.IsAtEnd(); it.Advance()) {
+      bounds.UnionWith(it.rect());
+    }
+  }
+  webrtc::VideoFrame::UpdateRect update_rect{bounds.left(), bounds.top(),
+                                             bounds.width(), bounds.height()};
+
+  // Counted first, a sink reading GetStats() from OnFrame() sees this frame.
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    ++stats_.delivered;
+    stats_.converted_pixels += converted;
+  }
+  OnFrame(webrtc::VideoFrame::Builder()
+              .set_video_frame_buffer(buffer)
+              .set_timestamp_us(rtc::TimeMicros())
+              .set_rotation(webrtc::kVideoRotation_0)
+              .set_update_rect(update_rect)
+              .build());
+}
+
+int64_t ScreenCapturer::Convert(const webrtc::DesktopFrame& frame,
+                                const webrtc::DesktopRegion& region,
+                                webrtc::I420Buffer* buffer) {
+  const int width = frame.size().width();
+  const int height = frame.size().height();
+  int64_t pixels = 0;
+  for (webrtc::DesktopRegion::Iterator it(region); !it.IsAtEnd();
+       it.Advance()) {
+    // Chroma is subsampled 2x2, grow the rectangle to even coordinates.
+    int left = it.rect().left() & ~1;
+    int top = it.rect().top() & ~1;
+    int right = std::min(width, (it.rect().right() + 1) & ~1);
+    int bottom = std::min(height, (it.rect().bottom() + 1) & ~1);
+    if (right <= left || bottom <= top) {
+      continue;
+    }
+    // DesktopFrame is BGRA in memory, libyuv calls that ARGB.
+    libyuv::ARGBToI420(
+        frame.GetFrameDataAtPos(webrtc::DesktopVector(left, top)),
+        frame.stride(),
+        buffer->MutableDataY() + top * buffer->StrideY() + left,
+        buffer->StrideY(),
+        buffer->MutableDataU() + (top / 2) * buffer->StrideU() + left / 2,
+        buffer->StrideU(),
+        buffer->MutableDataV() + (top / 2) * buffer->StrideV() + left / 2,
+        buffer->StrideV(), right - left, bottom - top);
+    pixels += static_cast<int64_t>(right - left) * (bottom - top);
+  }
+  return pixels;
+}
+}  // namespace strtc
@@ -0,0 +1,84 @@
+#ifndef STRTC_SCREEN_CAPTURER_H_
+#define STRTC_SCREEN_CAPTURER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "api/video/i420_buffer.h"
+#include "common_video/include/video_frame_buffer_pool.h"
+#include "modules/desktop_capture/desktop_capturer.h"
+#include "modules/desktop_capture/desktop_region.h"
+#include "test/test_video_capturer.h"
+
+namespace strtc {
+// Screen or window capture through modules/desktop_capture on an own
+// thread. Unchanged screens produce no frame, and only the updated region
+// of a capture is converted to I420, into pooled buffers that remember
+// which parts of them are stale. CPU cost follows the amount of change,
+// not the resolution.
+class ScreenCapturer : public webrtc::test::TestVideoCapturer,
+                       public webrtc::DesktopCapturer::Callback {
+ public:
+  // `source_id` is a screen id, webrtc::kFullDesktopScreenId for all of
+  // them, or with `window` set a window id from GetSources().
+  static std::unique_ptr<ScreenCapturer> Create(
+      int fps, webrtc::DesktopCapturer::SourceId source_id, bool window);
+  // Uses `capturer`, e.g. a webrtc::FakeDesktopCapturer, instead of the
+  // platform one. It is only touched on the capture thread.
+  static std::unique_ptr<ScreenCapturer> Create(
+      int fps, std::unique_ptr<webrtc::DesktopCapturer> capturer);
+  ~ScreenCapturer() override;
+
+  // The screens, or with `window` set the windows, that can be captured.
+  static bool GetSources(bool window,
+                         webrtc::DesktopCapturer::SourceList* sources);
+
+  struct Stats {
+    int64_t captured = 0;
+    // Captures without any change, not delivered.
+    int64_t unchanged = 0;
+    int64_t delivered = 0;
+    // Pixels converted to I420, over all delivered frames.
+    int64_t converted_pixels = 0;
+  };
+  Stats GetStats();
+
+ private:
+  ScreenCapturer(int fps, std::unique_ptr<webrtc::DesktopCapturer> capturer);
+
+  static std::unique_ptr<webrtc::DesktopCapturer> CreatePlatformCapturer(
+      bool window);
+
+  void Run();
+  // webrtc::DesktopCapturer::Callback
+  void OnCaptureResult(webrtc::DesktopCapturer::Result result,
+                       std::unique_ptr<webrtc::DesktopFrame> frame) override;
+
+  int64_t Convert(const webrtc::DesktopFrame& frame,
+                  const webrtc::DesktopRegion& region,
+                  webrtc::I420Buffer* buffer);
+
+ private:
+  const int fps_;
+  std::unique_ptr<webrtc::DesktopCapturer> capturer_;
+
+  // Only used on the capture thread.
+  webrtc::DesktopSize size_;
+  webrtc::VideoFrameBufferPool buffer_pool_;
+  // Pooled buffer -> the parts of it that are older than the last capture.
+  std::map<const webrtc::I420Buffer*, webrtc::DesktopRegion> stale_regions_;
+
+  std::mutex stats_mutex_;
+  Stats stats_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  bool stopped_ = false;
+  std::thread thread_;
+};
+}  // namespace strtc
+#endif  // STRTC_SCREEN_CAPTURER_H_
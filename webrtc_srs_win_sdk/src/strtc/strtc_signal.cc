@@ -0,0 +1,16 @@
+#include "strtc_signal.h"
+
+#include "absl/strings/match.h"
+#include "strtc_srs_signal.h"
+#include "strtc_whip_signal.h"
+
+namespace strtc {
+std::unique_ptr<StrtcSignal> StrtcSignal::Create(const std::string& url,
+                                                 HttpRequestLoop* http_loop) {
+  if (absl::StartsWith(url, "whip://") || absl::StartsWith(url, "whips://") ||
+      absl::StartsWith(url, "whep://") || absl::StartsWith(url, "wheps://")) {
+    return std::make_unique<StrtcWhipSignal>(http_loop);
+  }
+  return std::make_unique<StrtcSrsSignal>(http_loop);
+}
+}  // namespace strtc
@@ -0,0 +1,41 @@
+#ifndef STRTC_SIGNAL_H_
+#define STRTC_SIGNAL_H_
+
+#include <functional>
+#include <memory>
+
+#include "strtc_common_define.h"
+#include "strtc_http_request_loop.h"
+
+namespace strtc {
+// Signaling backend of a channel, picked from the url scheme:
+//   webrtc://host:port/app/stream         SRS http api (/rtc/v1/publish/)
+//   whip://host:port/path, whips://...    WHIP
+//   whep://host:port/path, wheps://...    WHEP
+class StrtcSignal {
+ public:
+  // Called with 0 and the remote sdp on success, -1 otherwise.
+  using SignalCallback =
+      std::function<void(int code, const std::string& answer)>;
+
+  static std::unique_ptr<StrtcSignal> Create(const std::string& url,
+                                             HttpRequestLoop* http_loop);
+
+  virtual ~StrtcSignal() = default;
+
+  // Sends the local offer. The callback runs on the http loop thread, or
+  // synchronously when no loop was given.
+  virtual void postAsync(const std::string& url, const std::string& offer,
+                         ChannelType type, SignalCallback callback) = 0;
+
+  // Trickles a local candidate ("candidate:..."). Backends whose server
+  // does not take client candidates ignore it.
+  virtual void addCandidate(const std::string& mid, int mline_index,
+                            const std::string& candidate) {}
+  virtual void endOfCandidates() {}
+
+  // Releases the session on the server. Safe to call more than once.
+  virtual void close() {}
+};
+}  // namespace strtc
+#endif  // STRTC_SIGNAL_H_
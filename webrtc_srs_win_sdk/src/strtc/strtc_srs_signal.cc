@@ -10,18 +10,60 @@ constexpr int kDefaultSignalConnTimeoutMs = 5000;
 constexpr char SRS_BASE_URL_PUBLISH[] = "/rtc/v1/publish/";
 constexpr char SRS_BASE_URL_SUBSCRIBE[] = "/rtc/v1/play/";
 
-StrtcSrsSignal::StrtcSrsSignal() { RTC_LOG(LS_INFO) << __FUNCTION__; }
+StrtcSrsSignal::StrtcSrsSignal(HttpRequestLoop* http_loop)
+    : http_loop_(http_loop) {
+  RTC_LOG(LS_INFO) << __FUNCTION__;
+}
 
 StrtcSrsSignal::~StrtcSrsSignal() { RTC_LOG(LS_INFO) << __FUNCTION__; }
 
 // url: "webrtc://172.16.28.35:1985/live/livestream"
 int StrtcSrsSignal::post(const std::string& url, const std::string& offer,
                          std::string* answer, ChannelType type) {
+  std::unique_ptr<HttpClient> http_client = createRequest(url, offer, type);
+  if (!http_client) {
+    return -1;
+  }
+  return parseResponse(http_client->DoEasy(), http_client.get(), answer);
+}
+
+void StrtcSrsSignal::postAsync(const std::string& url,
+                               const std::string& offer, ChannelType type,
+                               SignalCallback callback) {
+  if (!http_loop_) {
+    std::string answer;
+    int code = post(url, offer, &answer, type);
+    if (callback) {
+      callback(code, answer);
+    }
+    return;
+  }
+
+  std::unique_ptr<HttpClient> http_client = createRequest(url, offer, type);
+  if (!http_client) {
+    if (callback) {
+      callback(-1, "");
+    }
+    return;
+  }
+
+  http_loop_->Perform(std::move(http_client),
+                      [callback](int code, HttpClient* http_client) {
+                        std::string answer;
+                        code = parseResponse(code, http_client, &answer);
+                        if (callback) {
+                          callback(code, answer);
+                        }
+                      });
+}
+
+std::unique_ptr<HttpClient> StrtcSrsSignal::createRequest(
+    const std::string& url, const std::string& offer, ChannelType type) {
   std::vector<std::string> fields;
   rtc::split(url, '/', &fields);
   if (fields.size() < 3) {
     RTC_LOG(LS_ERROR) << __FUNCTION__ << " url no host";
-    return -1;
+    return nullptr;
   }
   std::string http_url =
       "http://" + fields[2] +
@@ -33,12 +75,12 @@ int StrtcSrsSignal::post(const std::string& url, const std::string& offer,
   if (tokens.size() >= 2) {
     http_url += "?" + tokens[1];
   }
-#if 1
-  http_client_.reset(new HttpClient(http_url, kDefaultSignalTimeoutMs,
-                                    kDefaultSignalConnTimeoutMs));
-  if (!http_client_) {
+
+  std::unique_ptr<HttpClient> http_client(new HttpClient(
+      http_url, kDefaultSignalTimeoutMs, kDefaultSignalConnTimeoutMs));
+  if (!http_client || !http_client->GetHandle()) {
     RTC_LOG(LS_ERROR) << __FUNCTION__ << " http client is nullptr";
-    return -1;
+    return nullptr;
   }
 
   Json::StreamWriterBuilder writer_builder;
@@ -52,10 +94,14 @@ int StrtcSrsSignal::post(const std::string& url, const std::string& offer,
 
   std::string request_str = Json::writeString(writer_builder, body);
 
-  http_client_->AddHeader("Content-Type", "application/json");
+  http_client->AddHeader("Content-Type", "application/json");
   // http_->AddHeader("RequestId", request_id_);
-  http_client_->AddContent(true, "", request_str);
-  int code = http_client_->DoEasy();
+  http_client->AddContent(true, "", request_str);
+  return http_client;
+}
+
+int StrtcSrsSignal::parseResponse(int code, HttpClient* http_client,
+                                  std::string* answer) {
   if (code != 0) {
     RTC_LOG(LS_ERROR) << __FUNCTION__ << " request failed code:" << code;
     return -1;
@@ -65,8 +111,8 @@ int StrtcSrsSignal::post(const std::string& url, const std::string& offer,
   std::unique_ptr<Json::CharReader> reader(reader_builder.newCharReader());
   std::string json_err;
 
-  body.clear();
-  std::string content = http_client_->GetContent();
+  Json::Value body;
+  const std::string& content = http_client->GetContent();
   if (!reader->parse(content.c_str(), content.c_str() + content.length(), &body,
                      &json_err) ||
       !body.isObject()) {
@@ -76,9 +122,6 @@ int StrtcSrsSignal::post(const std::string& url, const std::string& offer,
     return -1;
   }
 
-  writer_builder["commentStyle"] = "All";
-  writer_builder["indentation"] = "";
-
   code = body["code"].asInt64();
   if (code == 0) {
     std::string _answer = body["sdp"].asString();
@@ -86,31 +129,6 @@ int StrtcSrsSignal::post(const std::string& url, const std::string& offer,
   } else {
     RTC_LOG(LS_ERROR) << __FUNCTION__ << " srs occur failed code:" << code;
   }
-#else
-  // WHIP
-  http_url = "http://172.16.28.35:1985/rtc/v1/whip/?app=live&stream=livestream";
-  http_client_.reset(new HttpClient(http_url, kDefaultSignalTimeoutMs,
-                                    kDefaultSignalConnTimeoutMs));
-  if (!http_client_) {
-    RTC_LOG(LS_ERROR) << __FUNCTION__ << " http client is nullptr";
-    return -1;
-  }
-
-  http_client_->AddHeader("Content-Type", "application/sdp");
-  // http_->AddHeader("RequestId", request_id_);
-  http_client_->AddContent(true, "", offer);
-  int code = http_client_->DoEasy();
-  if (code != 0) {
-    RTC_LOG(LS_ERROR) << __FUNCTION__ << " request failed code:" << code;
-    return -1;
-  }
-  std::string content = http_client_->GetContent();
-  int status_code = http_client_->GetHttpStatusCode();
-  if (status_code == 201) {
-    *answer = content;
-  }
-#endif
-  http_client_.reset(nullptr);
   return code;
 }
 }  // namespace strtc
\ No newline at end of file
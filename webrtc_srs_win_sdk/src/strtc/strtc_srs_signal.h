@@ -3,20 +3,29 @@
 
 #include <memory>
 
-#include "strtc_common_define.h"
 #include "strtc_http_client.h"
+#include "strtc_signal.h"
 
 namespace strtc {
-class StrtcSrsSignal {
+class StrtcSrsSignal : public StrtcSignal {
  public:
-  StrtcSrsSignal();
-  ~StrtcSrsSignal();
+  explicit StrtcSrsSignal(HttpRequestLoop* http_loop = nullptr);
+  ~StrtcSrsSignal() override;
 
   int post(const std::string& url, const std::string& offer,
            std::string* answer, ChannelType type);
+  void postAsync(const std::string& url, const std::string& offer,
+                 ChannelType type, SignalCallback callback) override;
 
  private:
-  std::unique_ptr<HttpClient> http_client_;
+  std::unique_ptr<HttpClient> createRequest(const std::string& url,
+                                            const std::string& offer,
+                                            ChannelType type);
+  static int parseResponse(int code, HttpClient* http_client,
+                           std::string* answer);
+
+ private:
+  HttpRequestLoop* http_loop_;
   std::string request_id_;
 };
 }  // namespace strtc
@@ -0,0 +1,384 @@
+#include "strtc_stats_collector.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "api/stats/rtc_stats_collector_callback.h"
+#include "api/stats/rtcstats_objects.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/time_utils.h"
+
+namespace strtc {
+namespace {
+class StatsRequest : public webrtc::RTCStatsCollectorCallback {
+ public:
+  using Callback = std::function<void(
+      const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report)>;
+
+  explicit StatsRequest(Callback callback) : callback_(std::move(callback)) {}
+
+  void OnStatsDelivered(
+      const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report)
+      override {
+    callback_(report);
+  }
+
+ private:
+  Callback callback_;
+};
+
+template <typename T>
+T ValueOr(const webrtc::RTCStatsMember<T>& member, T value) {
+  return member.is_defined() ? *member : value;
+}
+
+bool IsVideo(const webrtc::RTCRTPStreamStats& stats) {
+  return ValueOr(stats.kind, std::string()) == "video";
+}
+
+// Per unit of `count`, in milliseconds.
+double AverageMs(double seconds, uint64_t count) {
+  return count > 0 ? seconds * 1000 / count : 0;
+}
+}  // namespace
+
+ChannelStatsReducer::ChannelStatsReducer(int channel_id, ChannelType type)
+    : channel_id_(channel_id), type_(type) {}
+
+ChannelStats ChannelStatsReducer::Reduce(const webrtc::RTCStatsReport& report) {
+  ChannelStats stats;
+  stats.channelId = channel_id_;
+  stats.type = type_;
+  stats.timestampMs = report.timestamp_us() / rtc::kNumMicrosecsPerMillisec;
+
+  Totals totals;
+  totals.timestamp_us = report.timestamp_us();
+
+  if (type_ == PUBLISH) {
+    for (const auto* outbound :
+         report.GetStatsOfType<webrtc::RTCOutboundRTPStreamStats>()) {
+      totals.bytes += ValueOr(outbound->bytes_sent, uint64_t(0));
+      if (!IsVideo(*outbound)) {
+        continue;
+      }
+      // Simulcast layers add up, the largest one describes the stream.
+      int width = static_cast<int>(ValueOr(outbound->frame_width, 0u));
+      int height = static_cast<int>(ValueOr(outbound->frame_height, 0u));
+      double fps = ValueOr(outbound->frames_per_second, 0.0);
+      if (width >= stats.frameWidth) {
+        stats.frameWidth = width;
+        stats.frameHeight = height;
+        stats.framesPerSecond = fps;
+      }
+      std::string reason =
+          ValueOr(outbound->quality_limitation_reason, std::string());
+      std::string rid = ValueOr(outbound->rid, std::string());
+      if (!rid.empty()) {
+        uint64_t bytes = ValueOr(outbound->bytes_sent, uint64_t(0));
+        totals.layer_bytes[rid] = bytes;
+        LayerStats layer;
+        layer.rid = rid;
+        layer.framesPerSecond = fps;
+        layer.frameWidth = width;
+        layer.frameHeight = height;
+        layer.qualityLimitationReason = reason;
+        auto previous = previous_.layer_bytes.find(rid);
+        int64_t elapsed_us = totals.timestamp_us - previous_.timestamp_us;
+        if (previous != previous_.layer_bytes.end() && elapsed_us > 0 &&
+            bytes >= previous->second) {
+          layer.bitrateKbps = static_cast<int64_t>(
+              (bytes - previous->second) * 8 * 1000 / elapsed_us);
+        }
+        stats.layers.push_back(layer);
+      }
+      if (stats.qualityLimitationReason.empty() ||
+          stats.qualityLimitationReason == "none") {
+        stats.qualityLimitationReason = reason;
+      }
+      totals.encode_time += ValueOr(outbound->total_encode_time, 0.0);
+      totals.frames_encoded += ValueOr(outbound->frames_encoded, 0u);
+    }
+    for (const auto* remote :
+         report.GetStatsOfType<webrtc::RTCRemoteInboundRtpStreamStats>()) {
+      totals.packets_lost += ValueOr(remote->packets_lost, 0);
+      stats.packetLossPercent = std::max(
+          stats.packetLossPercent, ValueOr(remote->fraction_lost, 0.0) * 100);
+      stats.rttMs =
+          std::max(stats.rttMs, ValueOr(remote->round_trip_time, 0.0) * 1000);
+    }
+  } else {
+    for (const auto* inbound :
+         report.GetStatsOfType<webrtc::RTCInboundRTPStreamStats>()) {
+      totals.bytes += ValueOr(inbound->bytes_received, uint64_t(0));
+      totals.packets_lost += ValueOr(inbound->packets_lost, 0);
+      totals.packets_received += ValueOr(inbound->packets_received, 0u);
+      if (!IsVideo(*inbound)) {
+        continue;
+      }
+      stats.frameWidth = static_cast<int>(ValueOr(inbound->frame_width, 0u));
+      stats.frameHeight = static_cast<int>(ValueOr(inbound->frame_height, 0u));
+      stats.framesPerSecond = ValueOr(inbound->frames_per_second, 0.0);
+      totals.jitter_buffer_delay += ValueOr(inbound->jitter_buffer_delay, 0.0);
+      totals.jitter_buffer_emitted +=
+          ValueOr(inbound->jitter_buffer_emitted_count, uint64_t(0));
+      totals.decode_time += ValueOr(inbound->total_decode_time, 0.0);
+      totals.frames_decoded += ValueOr(inbound->frames_decoded, 0u);
+    }
+    for (const auto* track :
+         report.GetStatsOfType<webrtc::RTCMediaStreamTrackStats>()) {
+      if (ValueOr(track->kind, std::string()) != "video") {
+        continue;
+      }
+      stats.freezeCount += ValueOr(track->freeze_count, 0u);
+      stats.freezeDurationMs +=
+          ValueOr(track->total_freezes_duration, 0.0) * 1000;
+    }
+    int64_t lost = totals.packets_lost - previous_.packets_lost;
+    int64_t received = static_cast<int64_t>(totals.packets_received -
+                                            previous_.packets_received);
+    if (lost > 0 && lost + received > 0) {
+      stats.packetLossPercent = lost * 100.0 / (lost + received);
+    }
+  }
+  stats.packetsLost = totals.packets_lost;
+
+  if (stats.rttMs == 0) {
+    for (const auto* pair :
+         report.GetStatsOfType<webrtc::RTCIceCandidatePairStats>()) {
+      if (ValueOr(pair->nominated, false) &&
+          ValueOr(pair->state, std::string()) == "succeeded") {
+        stats.rttMs = ValueOr(pair->current_round_trip_time, 0.0) * 1000;
+      }
+    }
+  }
+
+  int64_t elapsed_us = totals.timestamp_us - previous_.timestamp_us;
+  if (previous_.timestamp_us > 0 && elapsed_us > 0 &&
+      totals.bytes >= previous_.bytes) {
+    stats.bitrateKbps = static_cast<int64_t>(
+        (totals.bytes - previous_.bytes) * 8 * 1000 / elapsed_us);
+  }
+  stats.jitterBufferDelayMs =
+      AverageMs(totals.jitter_buffer_delay - previous_.jitter_buffer_delay,
+                totals.jitter_buffer_emitted - previous_.jitter_buffer_emitted);
+  stats.encodeTimeMs =
+      AverageMs(totals.encode_time - previous_.encode_time,
+                totals.frames_encoded - previous_.frames_encoded);
+  stats.decodeTimeMs =
+      AverageMs(totals.decode_time - previous_.decode_time,
+                totals.frames_decoded - previous_.frames_decoded);
+
+  previous_ = totals;
+  return stats;
+}
+
+StrtcStatsCollector::StrtcStatsCollector(rtc::Thread* thread, int interval_ms,
+                                         StatsCallback on_stats)
+    : thread_(thread),
+      interval_ms_(interval_ms),
+      on_stats_(std::move(on_stats)),
+      state_(std::make_shared<State>()) {
+  schedulePoll();
+}
+
+StrtcStatsCollector::~StrtcStatsCollector() {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->stopped = true;
+}
+
+void StrtcStatsCollector::addChannel(
+    int channel_id, rtc::scoped_refptr<StrtcPeerConnectionChannel> channel) {
+  channels_[channel_id] = channel;
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->reducers[channel_id] = std::make_shared<ChannelStatsReducer>(
+      channel_id, channel->getChannelType());
+}
+
+void StrtcStatsCollector::removeChannel(int channel_id) {
+  channels_.erase(channel_id);
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->reducers.erase(channel_id);
+  state_->latest.erase(channel_id);
+}
+
+std::vector<ChannelStats> StrtcStatsCollector::getStats() {
+  std::vector<ChannelStats> stats;
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  for (const auto& it : state_->latest) {
+    stats.push_back(it.second);
+  }
+  return stats;
+}
+
+void StrtcStatsCollector::schedulePoll() {
+  std::shared_ptr<State> state = state_;
+  thread_->PostDelayedTask(webrtc::ToQueuedTask([this, state]() {
+                             {
+                               std::lock_guard<std::mutex> lock(state->mutex);
+                               if (state->stopped) {
+                                 return;
+                               }
+                             }
+                             poll();
+                             schedulePoll();
+                           }),
+                           static_cast<uint32_t>(interval_ms_));
+}
+
+void StrtcStatsCollector::poll() {
+  for (const auto& it : channels_) {
+    int channel_id = it.first;
+    std::shared_ptr<State> state = state_;
+    rtc::Thread* thread = thread_;
+    StatsCallback on_stats = on_stats_;
+    auto request = rtc::make_ref_counted<StatsRequest>(
+        [state, thread, channel_id, on_stats](
+            const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report) {
+          // Reduced where the report arrives, the engine thread only gets
+          // the result.
+          ChannelStats stats;
+          {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            auto reducer = state->reducers.find(channel_id);
+            if (state->stopped || reducer == state->reducers.end()) {
+              return;
+            }
+            stats = reducer->second->Reduce(*report);
+            state->latest[channel_id] = stats;
+          }
+          thread->PostTask(webrtc::ToQueuedTask([state, stats, on_stats]() {
+            {
+              std::lock_guard<std::mutex> lock(state->mutex);
+              if (state->stopped) {
+                return;
+              }
+            }
+            if (on_stats) {
+              on_stats(stats);
+            }
+          }));
+        });
+    it.second->getStats(request);
+  }
+}
+
+std::string StrtcStatsCollector::toPrometheus(
+    const std::vector<ChannelStats>& stats) {
+  struct Metric {
+    const char* name;
+    const char* help;
+    std::function<double(const ChannelStats&)> value;
+  };
+  static const Metric kMetrics[] = {
+      {"strtc_channel_bitrate_kbps", "Media bitrate.",
+       [](const ChannelStats& s) { return double(s.bitrateKbps); }},
+      {"strtc_channel_frames_per_second", "Video frame rate.",
+       [](const ChannelStats& s) { return s.framesPerSecond; }},
+      {"strtc_channel_frame_width", "Video frame width.",
+       [](const ChannelStats& s) { return double(s.frameWidth); }},
+      {"strtc_channel_frame_height", "Video frame height.",
+       [](const ChannelStats& s) { return double(s.frameHeight); }},
+      {"strtc_channel_jitter_buffer_delay_ms",
+       "Average video jitter buffer delay.",
+       [](const ChannelStats& s) { return s.jitterBufferDelayMs; }},
+      {"strtc_channel_freezes", "Video freezes.",
+       [](const ChannelStats& s) { return double(s.freezeCount); }},
+      {"strtc_channel_freeze_duration_ms", "Total video freeze duration.",
+       [](const ChannelStats& s) { return s.freezeDurationMs; }},
+      {"strtc_channel_packets_lost", "Packets lost.",
+       [](const ChannelStats& s) { return double(s.packetsLost); }},
+      {"strtc_channel_packet_loss_percent", "Recent packet loss.",
+       [](const ChannelStats& s) { return s.packetLossPercent; }},
+      {"strtc_channel_rtt_ms", "Round trip time.",
+       [](const ChannelStats& s) { return s.rttMs; }},
+      {"strtc_channel_encode_time_ms", "Average video encode time.",
+       [](const ChannelStats& s) { return s.encodeTimeMs; }},
+      {"strtc_channel_decode_time_ms", "Average video decode time.",
+       [](const ChannelStats& s) { return s.decodeTimeMs; }},
+  };
+
+  std::ostringstream out;
+  for (const auto& metric : kMetrics) {
+    out << "# HELP " << metric.name << " " << metric.help << "\n";
+    out << "# TYPE " << metric.name << " gauge\n";
+    for (const auto& channel : stats) {
+      out << metric.name << "{channel=\"" << channel.channelId
+          << "\",type=\""
+          << (channel.type == PUBLISH ? "publish" : "subscribe") << "\"} "
+          << metric.value(channel) << "\n";
+    }
+  }
+  struct LayerMetric {
+    const char* name;
+    const char* help;
+    std::function<double(const LayerStats&)> value;
+  };
+  static const LayerMetric kLayerMetrics[] = {
+      {"strtc_layer_bitrate_kbps", "Simulcast layer bitrate.",
+       [](const LayerStats& s) { return double(s.bitrateKbps); }},
+      {"strtc_layer_frames_per_second", "Simulcast layer frame rate.",
+       [](const LayerStats& s) { return s.framesPerSecond; }},
+      {"strtc_layer_frame_height", "Simulcast layer frame height.",
+       [](const LayerStats& s) { return double(s.frameHeight); }},
+  };
+  for (const auto& metric : kLayerMetrics) {
+    out << "# HELP " << metric.name << " " << metric.help << "\n";
+    out << "# TYPE " << metric.name << " gauge\n";
+    for (const auto& channel : stats) {
+      for (const auto& layer : channel.layers) {
+        out << metric.name << "{channel=\"" << channel.channelId
+            << "\",rid=\"" << layer.rid << "\"} " << metric.value(layer)
+            << "\n";
+      }
+    }
+  }
+  out << "# HELP strtc_channel_quality_limitation Encoder limitation.\n";
+  out << "# TYPE strtc_channel_quality_limitation gauge\n";
+  for (const auto& channel : stats) {
+    if (channel.type != PUBLISH) {
+      continue;
+    }
+    out << "strtc_channel_quality_limitation{channel=\"" << channel.channelId
+        << "\",reason=\"" << channel.qualityLimitationReason << "\"} 1\n";
+  }
+  return out.str();
+}
+
+std::string StrtcStatsCollector::toJson(
+    const std::vector<ChannelStats>& stats) {
+  std::ostringstream out;
+  out << "{\"channels\":[";
+  for (size_t i = 0; i < stats.size(); ++i) {
+    const ChannelStats& s = stats[i];
+    out << (i > 0 ? "," : "") << "{\"channelId\":" << s.channelId
+        << ",\"type\":\"" << (s.type == PUBLISH ? "publish" : "subscribe")
+        << "\",\"timestampMs\":" << s.timestampMs
+        << ",\"bitrateKbps\":" << s.bitrateKbps
+        << ",\"framesPerSecond\":" << s.framesPerSecond
+        << ",\"frameWidth\":" << s.frameWidth
+        << ",\"frameHeight\":" << s.frameHeight
+        << ",\"jitterBufferDelayMs\":" << s.jitterBufferDelayMs
+        << ",\"freezeCount\":" << s.freezeCount
+        << ",\"freezeDurationMs\":" << s.freezeDurationMs
+        << ",\"packetsLost\":" << s.packetsLost
+        << ",\"packetLossPercent\":" << s.packetLossPercent
+        << ",\"rttMs\":" << s.rttMs << ",\"qualityLimitationReason\":\""
+        << s.qualityLimitationReason << "\""
+        << ",\"encodeTimeMs\":" << s.encodeTimeMs
+        << ",\"decodeTimeMs\":" << s.decodeTimeMs << ",\"layers\":[";
+    for (size_t j = 0; j < s.layers.size(); ++j) {
+      const LayerStats& l = s.layers[j];
+      out << (j > 0 ? "," : "") << "{\"rid\":\"" << l.rid
+          << "\",\"bitrateKbps\":" << l.bitrateKbps
+          << ",\"framesPerSecond\":" << l.framesPerSecond
+          << ",\"frameWidth\":" << l.frameWidth
+          << ",\"frameHeight\":" << l.frameHeight
+          << ",\"qualityLimitationReason\":\"" << l.qualityLimitationReason
+          << "\"}";
+    }
+    out << "]}";
+  }
+  out << "]}";
+  return out.str();
+}
+}  // namespace strtc
@@ -0,0 +1,90 @@
+#ifndef STRTC_STATS_COLLECTOR_H_
+#define STRTC_STATS_COLLECTOR_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "api/stats/rtc_stats_report.h"
+#include "rtc_base/thread.h"
+#include "strtc_common_define.h"
+#include "strtc_peer_connection_channel.h"
+
+namespace strtc {
+// Turns successive RTCStatsReports of one channel into ChannelStats. Keeps
+// the previous totals, so rates and averages cover one interval.
+class ChannelStatsReducer {
+ public:
+  ChannelStatsReducer(int channel_id, ChannelType type);
+
+  ChannelStats Reduce(const webrtc::RTCStatsReport& report);
+
+ private:
+  struct Totals {
+    int64_t timestamp_us = 0;
+    uint64_t bytes = 0;
+    double jitter_buffer_delay = 0;
+    uint64_t jitter_buffer_emitted = 0;
+    double encode_time = 0;
+    uint64_t frames_encoded = 0;
+    double decode_time = 0;
+    uint64_t frames_decoded = 0;
+    int64_t packets_lost = 0;
+    uint64_t packets_received = 0;
+    // Simulcast rid -> bytes sent.
+    std::map<std::string, uint64_t> layer_bytes;
+  };
+
+ private:
+  const int channel_id_;
+  const ChannelType type_;
+  Totals previous_;
+};
+
+// Pulls the RTC stats of every added channel on `thread`, every
+// `interval_ms`. Reports arrive on the signaling thread, are reduced there
+// and handed to `on_stats` on `thread`.
+class StrtcStatsCollector {
+ public:
+  using StatsCallback = std::function<void(const ChannelStats& stats)>;
+
+  StrtcStatsCollector(rtc::Thread* thread, int interval_ms,
+                      StatsCallback on_stats);
+  ~StrtcStatsCollector();
+
+  // Called on `thread`.
+  void addChannel(int channel_id,
+                  rtc::scoped_refptr<StrtcPeerConnectionChannel> channel);
+  void removeChannel(int channel_id);
+
+  // Latest stats of every channel, any thread.
+  std::vector<ChannelStats> getStats();
+
+  static std::string toPrometheus(const std::vector<ChannelStats>& stats);
+  static std::string toJson(const std::vector<ChannelStats>& stats);
+
+ private:
+  // Shared with the stats requests in flight, which may outlive the
+  // collector.
+  struct State {
+    std::mutex mutex;
+    bool stopped = false;
+    std::map<int, std::shared_ptr<ChannelStatsReducer>> reducers;
+    std::map<int, ChannelStats> latest;
+  };
+
+  void poll();
+  void schedulePoll();
+
+ private:
+  rtc::Thread* thread_;
+  const int interval_ms_;
+  StatsCallback on_stats_;
+  std::shared_ptr<State> state_;
+  std::map<int, rtc::scoped_refptr<StrtcPeerConnectionChannel>> channels_;
+};
+}  // namespace strtc
+#endif  // STRTC_STATS_COLLECTOR_H_
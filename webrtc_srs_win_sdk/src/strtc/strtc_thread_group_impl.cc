@@ -0,0 +1,176 @@
+#include "strtc_thread_group_impl.h"
+
+#if defined(WEBRTC_POSIX)
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#endif
+
+#include "rtc_base/logging.h"
+#include "rtc_base/task_utils/to_queued_task.h"
+#include "rtc_base/time_utils.h"
+
+namespace strtc {
+constexpr int kLoadSampleIntervalMs = 1000;
+
+std::shared_ptr<StrtcThreadGroup> StrtcThreadGroup::create(
+    const ThreadGroupConfig& config) {
+  std::shared_ptr<StrtcThreadGroupImpl> group =
+      std::make_shared<StrtcThreadGroupImpl>(config);
+  if (!group->start()) {
+    return nullptr;
+  }
+  return group;
+}
+
+StrtcThreadGroupImpl::StrtcThreadGroupImpl(const ThreadGroupConfig& config) {
+  network_.options = config.network;
+  network_.thread = rtc::Thread::CreateWithSocketServer();
+  worker_.options = config.worker;
+  worker_.thread = rtc::Thread::Create();
+  signaling_.options = config.signaling;
+  signaling_.thread = rtc::Thread::Create();
+}
+
+StrtcThreadGroupImpl::~StrtcThreadGroupImpl() {
+  // Drops the pending load samples, they point into this object.
+  signaling_.thread->Stop();
+  worker_.thread->Stop();
+  network_.thread->Stop();
+}
+
+bool StrtcThreadGroupImpl::start() {
+  return startThread(&network_) && startThread(&worker_) &&
+         startThread(&signaling_);
+}
+
+std::vector<ThreadLoad> StrtcThreadGroupImpl::getLoad() {
+  std::vector<ThreadLoad> loads;
+  for (ManagedThread* managed : {&network_, &worker_, &signaling_}) {
+    std::lock_guard<std::mutex> lock(managed->mutex);
+    loads.push_back(managed->load);
+  }
+  return loads;
+}
+
+bool StrtcThreadGroupImpl::startThread(ManagedThread* managed) {
+  managed->thread->SetName(managed->options.name, nullptr);
+  managed->load.name = managed->options.name;
+  if (!managed->thread->Start()) {
+    RTC_LOG(LS_ERROR) << __FUNCTION__ << " start " << managed->options.name
+                      << " failed";
+    return false;
+  }
+
+  ThreadOptions options = managed->options;
+  managed->thread->PostTask(webrtc::ToQueuedTask([managed, options]() {
+    applyOptions(options);
+    managed->last_sample_ms = rtc::TimeMillis();
+    managed->last_cpu_us = currentThreadCpuUs();
+    sample(managed, managed->last_sample_ms);
+  }));
+  return true;
+}
+
+void StrtcThreadGroupImpl::applyOptions(const ThreadOptions& options) {
+#if defined(WEBRTC_WIN)
+  int priority = THREAD_PRIORITY_NORMAL;
+  switch (options.priority) {
+    case THREAD_PRIO_LOW:
+      priority = THREAD_PRIORITY_BELOW_NORMAL;
+      break;
+    case THREAD_PRIO_HIGH:
+      priority = THREAD_PRIORITY_HIGHEST;
+      break;
+    case THREAD_PRIO_REALTIME:
+      priority = THREAD_PRIORITY_TIME_CRITICAL;
+      break;
+    default:
+      break;
+  }
+  if (!::SetThreadPriority(::GetCurrentThread(), priority)) {
+    RTC_LOG(LS_WARNING) << __FUNCTION__ << " set priority of " << options.name
+                        << " failed: " << ::GetLastError();
+  }
+  if (options.affinityMask != 0 &&
+      !::SetThreadAffinityMask(::GetCurrentThread(),
+                               static_cast<DWORD_PTR>(options.affinityMask))) {
+    RTC_LOG(LS_WARNING) << __FUNCTION__ << " set affinity of " << options.name
+                        << " failed: " << ::GetLastError();
+  }
+#elif defined(WEBRTC_LINUX)
+  if (options.priority == THREAD_PRIO_HIGH ||
+      options.priority == THREAD_PRIO_REALTIME) {
+    sched_param param;
+    param.sched_priority = options.priority == THREAD_PRIO_REALTIME
+                               ? sched_get_priority_max(SCHED_RR)
+                               : sched_get_priority_min(SCHED_RR);
+    if (pthread_setschedparam(pthread_self(), SCHED_RR, &param) != 0) {
+      RTC_LOG(LS_WARNING) << __FUNCTION__ << " set priority of "
+                          << options.name << " failed";
+    }
+  }
+  if (options.affinityMask != 0) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu) {
+      if (options.affinityMask & (1ull << cpu)) {
+        CPU_SET(cpu, &cpu_set);
+      }
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) !=
+        0) {
+      RTC_LOG(LS_WARNING) << __FUNCTION__ << " set affinity of "
+                          << options.name << " failed";
+    }
+  }
+#endif
+}
+
+int64_t StrtcThreadGroupImpl::currentThreadCpuUs() {
+#if defined(WEBRTC_WIN)
+  FILETIME creation_time, exit_time, kernel_time, user_time;
+  if (!::GetThreadTimes(::GetCurrentThread(), &creation_time, &exit_time,
+                        &kernel_time, &user_time)) {
+    return 0;
+  }
+  // FILETIME is in 100ns units.
+  ULARGE_INTEGER kernel, user;
+  kernel.LowPart = kernel_time.dwLowDateTime;
+  kernel.HighPart = kernel_time.dwHighDateTime;
+  user.LowPart = user_time.dwLowDateTime;
+  user.HighPart = user_time.dwHighDateTime;
+  return static_cast<int64_t>((kernel.QuadPart + user.QuadPart) / 10);
+#elif defined(WEBRTC_POSIX)
+  timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+    return 0;
+  }
+  return static_cast<int64_t>(ts.tv_sec) * rtc::kNumMicrosecsPerSec +
+         ts.tv_nsec / rtc::kNumNanosecsPerMicrosec;
+#else
+  return 0;
+#endif
+}
+
+void StrtcThreadGroupImpl::sample(ManagedThread* managed, int64_t expected_ms) {
+  int64_t now_ms = rtc::TimeMillis();
+  int64_t cpu_us = currentThreadCpuUs();
+  int64_t elapsed_ms = now_ms - managed->last_sample_ms;
+  {
+    std::lock_guard<std::mutex> lock(managed->mutex);
+    managed->load.queueDelayMs = now_ms - expected_ms;
+    if (elapsed_ms > 0) {
+      managed->load.cpuUsage =
+          (cpu_us - managed->last_cpu_us) / 10.0 / elapsed_ms;
+    }
+  }
+  managed->last_sample_ms = now_ms;
+  managed->last_cpu_us = cpu_us;
+
+  int64_t next_ms = now_ms + kLoadSampleIntervalMs;
+  managed->thread->PostDelayedTask(
+      webrtc::ToQueuedTask([managed, next_ms]() { sample(managed, next_ms); }),
+      kLoadSampleIntervalMs);
+}
+}  // namespace strtc
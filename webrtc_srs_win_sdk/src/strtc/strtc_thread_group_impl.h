@@ -0,0 +1,47 @@
+#ifndef STRTC_THREAD_GROUP_IMPL_H_
+#define STRTC_THREAD_GROUP_IMPL_H_
+
+#include <memory>
+#include <mutex>
+
+#include "rtc_base/thread.h"
+#include "strtc_thread_group.h"
+
+namespace strtc {
+class StrtcThreadGroupImpl : public StrtcThreadGroup {
+ public:
+  explicit StrtcThreadGroupImpl(const ThreadGroupConfig& config);
+  ~StrtcThreadGroupImpl() override;
+
+  bool start();
+
+  std::vector<ThreadLoad> getLoad() override;
+
+  rtc::Thread* network() { return network_.thread.get(); }
+  rtc::Thread* worker() { return worker_.thread.get(); }
+  rtc::Thread* signaling() { return signaling_.thread.get(); }
+
+ private:
+  struct ManagedThread {
+    ThreadOptions options;
+    std::unique_ptr<rtc::Thread> thread;
+
+    // Written on the thread itself by sample(), read under `mutex`.
+    std::mutex mutex;
+    ThreadLoad load;
+    int64_t last_sample_ms = 0;
+    int64_t last_cpu_us = 0;
+  };
+
+  static bool startThread(ManagedThread* managed);
+  static void applyOptions(const ThreadOptions& options);
+  static int64_t currentThreadCpuUs();
+  static void sample(ManagedThread* managed, int64_t expected_ms);
+
+ private:
+  ManagedThread network_;
+  ManagedThread worker_;
+  ManagedThread signaling_;
+};
+}  // namespace strtc
+#endif  // STRTC_THREAD_GROUP_IMPL_H_
@@ -1,97 +1,228 @@
-#include "strtc_vcm_capturer.h"
-
-#include "modules/video_capture/video_capture_factory.h"
-#include "rtc_base/checks.h"
-#include "rtc_base/logging.h"
-
-namespace strtc {
-VcmCapturer::VcmCapturer()
-    : vcm_(nullptr), thread_(rtc::Thread::CreateWithSocketServer()) {
-  thread_->Start();
-}
-
-bool VcmCapturer::Init(size_t width, size_t height, size_t target_fps,
-                       size_t capture_device_index) {
-  std::unique_ptr<webrtc::VideoCaptureModule::DeviceInfo> device_info(
-      webrtc::VideoCaptureFactory::CreateDeviceInfo());
-
-  char device_name[256];
-  char unique_name[256];
-  if (device_info->GetDeviceName(static_cast<uint32_t>(capture_device_index),
-                                 device_name, sizeof(device_name), unique_name,
-                                 sizeof(unique_name)) != 0) {
-    Destroy();
-    return false;
-  }
-
-  vcm_ = thread_->Invoke<rtc::scoped_refptr<webrtc::VideoCaptureModule>>(
-      RTC_FROM_HERE, [this, &unique_name] {
-        return CreateDeviceOnCurrentThread(unique_name);
-      });
-  if (!vcm_) {
-    return false;
-  }
-  vcm_->RegisterCaptureDataCallback(this);
-
-  device_info->GetCapability(vcm_->CurrentDeviceName(), 0, capability_);
-
-  capability_.width = static_cast<int32_t>(width);
-  capability_.height = static_cast<int32_t>(height);
-  capability_.maxFPS = static_cast<int32_t>(target_fps);
-  capability_.videoType = webrtc::VideoType::kI420;
-
-  if (thread_->Invoke<int32_t>(RTC_FROM_HERE, [this] {
-        return StartCaptureOnCurrentThread(capability_);
-      }) != 0) {
-    Destroy();
-    return false;
-  }
-
-  return true;
-}
-
-rtc::scoped_refptr<webrtc::VideoCaptureModule>
-VcmCapturer::CreateDeviceOnCurrentThread(const char* deviceUniqueIdUTF8) {
-  return webrtc::VideoCaptureFactory::Create(deviceUniqueIdUTF8);
-}
-
-int32_t VcmCapturer::StartCaptureOnCurrentThread(
-    webrtc::VideoCaptureCapability capability) {
-  return vcm_->StartCapture(capability);
-}
-
-int32_t VcmCapturer::StopCaptureOnCurrentThread() {
-  return vcm_->StopCapture();
-}
-
-void VcmCapturer::ReleaseOnCurrentThread() { vcm_ = nullptr; }
-
-VcmCapturer* VcmCapturer::Create(size_t width, size_t height, size_t target_fps,
-                                 size_t capture_device_index) {
-  std::unique_ptr<VcmCapturer> vcm_capturer(new VcmCapturer());
-  if (!vcm_capturer->Init(width, height, target_fps, capture_device_index)) {
-    RTC_LOG(LS_WARNING) << "Failed to create VcmCapturer(w = " << width
-                        << ", h = " << height << ", fps = " << target_fps
-                        << ")";
-    return nullptr;
-  }
-  return vcm_capturer.release();
-}
-
-void VcmCapturer::Destroy() {
-  if (!vcm_) {
-    return;
-  }
-  thread_->Invoke<int32_t>(RTC_FROM_HERE,
-                           [this] { return StopCaptureOnCurrentThread(); });
-  vcm_->DeRegisterCaptureDataCallback();
-  thread_->Invoke<void>(RTC_FROM_HERE,
-                        [this] { return ReleaseOnCurrentThread(); });
-}
-
-VcmCapturer::~VcmCapturer() { Destroy(); }
-
-void VcmCapturer::OnFrame(const webrtc::VideoFrame& frame) {
-  webrtc::test::TestVideoCapturer::OnFrame(frame);
-}
+#include "strtc_vcm_capturer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <tuple>
+
+#include "modules/video_capture/video_capture_factory.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/logging.h"
+
+namespace strtc {
+namespace {
+const char* VideoTypeName(webrtc::VideoType type) {
+  switch (type) {
+    case webrtc::VideoType::kI420:
+      return "I420";
+    case webrtc::VideoType::kIYUV:
+      return "IYUV";
+    case webrtc::VideoType::kYV12:
+      return "YV12";
+    case webrtc::VideoType::kYUY2:
+      return "YUY2";
+    case webrtc::VideoType::kUYVY:
+      return "UYVY";
+    case webrtc::VideoType::kMJPEG:
+      return "MJPEG";
+    case webrtc::VideoType::kRGB24:
+      return "RGB24";
+    case webrtc::VideoType::kRGB565:
+      return "RGB565";
+    case webrtc::VideoType::kARGB:
+      return "ARGB";
+    case webrtc::VideoType::kBGRA:
+      return "BGRA";
+    default:
+      return "unknown";
+  }
+}
+
+// Relative per-pixel cost of copy, repack, color conversion and MJPEG
+// decode, indexed by ConversionCost().
+constexpr int kConversionWeights[] = {1, 2, 4, 8};
+
+// -1 when VideoCaptureImpl cannot convert the format.
+int ConversionCost(webrtc::VideoType type) {
+  switch (type) {
+    case webrtc::VideoType::kI420:
+    case webrtc::VideoType::kIYUV:
+    case webrtc::VideoType::kYV12:
+      return 0;
+    case webrtc::VideoType::kYUY2:
+    case webrtc::VideoType::kUYVY:
+      return 1;
+    case webrtc::VideoType::kRGB24:
+    case webrtc::VideoType::kRGB565:
+    case webrtc::VideoType::kARGB:
+    case webrtc::VideoType::kBGRA:
+      return 2;
+    case webrtc::VideoType::kMJPEG:
+      return 3;
+    default:
+      return -1;
+  }
+}
+}  // namespace
+
+const char* CaptureFormat::conversion() const {
+  static const char* kConversions[] = {"copy", "repack", "convert",
+                                       "decode"};
+  return conversion_cost >= 0 && conversion_cost <= 3
+             ? kConversions[conversion_cost]
+             : "unknown";
+}
+
+VcmCapturer::VcmCapturer()
+    : vcm_(nullptr), thread_(rtc::Thread::CreateWithSocketServer()) {
+  thread_->Start();
+}
+
+bool VcmCapturer::Init(size_t width, size_t height, size_t target_fps,
+                       const VideoDevice& device) {
+  const std::string& unique_name = device.id;
+  vcm_ = thread_->Invoke<rtc::scoped_refptr<webrtc::VideoCaptureModule>>(
+      RTC_FROM_HERE, [this, &unique_name] {
+        return CreateDeviceOnCurrentThread(unique_name.c_str());
+      });
+  if (!vcm_) {
+    return false;
+  }
+  vcm_->RegisterCaptureDataCallback(this);
+
+  const std::vector<webrtc::VideoCaptureCapability>& capabilities =
+      device.capabilities;
+  if (SelectCaptureFormat(capabilities, static_cast<int>(width),
+                          static_cast<int>(height),
+                          static_cast<int>(target_fps), &capture_format_)) {
+    // Asked for exactly, so the device's best match is this mode and its
+    // native format, not a driver converted one.
+    capture_format_.device_id = device.id;
+    capability_ = capture_format_.capability;
+    if (capture_format_.scaled ||
+        capability_.maxFPS > static_cast<int32_t>(target_fps)) {
+      OnOutputFormatRequest(static_cast<int>(width), static_cast<int>(height),
+                            static_cast<int>(target_fps));
+    }
+  } else {
+    // Nothing enumerated, let the device match the request.
+    capability_.width = static_cast<int32_t>(width);
+    capability_.height = static_cast<int32_t>(height);
+    capability_.maxFPS = static_cast<int32_t>(target_fps);
+    capability_.videoType = webrtc::VideoType::kI420;
+    capture_format_.device_id = device.id;
+    capture_format_.capability = capability_;
+    capture_format_.video_type = "I420";
+    capture_format_.path = "I420 (device default)";
+  }
+  RTC_LOG(LS_INFO) << __FUNCTION__ << " " << vcm_->CurrentDeviceName()
+                   << " modes: " << capabilities.size()
+                   << " path: " << capture_format_.path;
+
+  if (thread_->Invoke<int32_t>(RTC_FROM_HERE, [this] {
+        return StartCaptureOnCurrentThread(capability_);
+      }) != 0) {
+    Destroy();
+    return false;
+  }
+
+  return true;
+}
+
+bool VcmCapturer::SelectCaptureFormat(
+    const std::vector<webrtc::VideoCaptureCapability>& capabilities,
+    int width, int height, int target_fps, CaptureFormat* format) {
+  const int64_t requested_pixels = static_cast<int64_t>(width) * height;
+  const webrtc::VideoCaptureCapability* best = nullptr;
+  // Compared in order, smaller is better.
+  std::tuple<int64_t, int, int64_t, int> best_key;
+  for (const auto& capability : capabilities) {
+    int cost = ConversionCost(capability.videoType);
+    if (cost < 0 || capability.interlaced) {
+      continue;
+    }
+    int64_t pixels = static_cast<int64_t>(capability.width) * capability.height;
+    bool covers = capability.width >= width && capability.height >= height;
+    bool scaled = capability.width != width || capability.height != height;
+    // The scaler reads the converted frame and writes the requested one.
+    int64_t frame_cost = pixels * kConversionWeights[cost] +
+                         (scaled ? pixels + requested_pixels : 0);
+    std::tuple<int64_t, int, int64_t, int> key(
+        covers ? 0 : requested_pixels - std::min(pixels, requested_pixels),
+        std::max(0, target_fps - capability.maxFPS),
+        frame_cost * std::max(1, capability.maxFPS),
+        std::abs(capability.maxFPS - target_fps));
+    if (!best || key < best_key) {
+      best = &capability;
+      best_key = key;
+    }
+  }
+  if (!best) {
+    return false;
+  }
+
+  format->capability = *best;
+  format->video_type = VideoTypeName(best->videoType);
+  format->conversion_cost = ConversionCost(best->videoType);
+  format->total_cost = std::get<2>(best_key);
+  format->scaled = best->width != width || best->height != height;
+  format->degraded = std::get<0>(best_key) > 0 || std::get<1>(best_key) > 0;
+
+  format->path = format->video_type + " " + std::to_string(best->width) +
+                 "x" + std::to_string(best->height) + "@" +
+                 std::to_string(best->maxFPS) + " -> I420 (" +
+                 format->conversion() + ")";
+  if (format->scaled || best->maxFPS > target_fps) {
+    format->path += " -> " + std::to_string(width) + "x" +
+                    std::to_string(height) + "@" + std::to_string(target_fps);
+  }
+  if (format->degraded) {
+    format->path += " (degraded)";
+  }
+  return true;
+}
+
+rtc::scoped_refptr<webrtc::VideoCaptureModule>
+VcmCapturer::CreateDeviceOnCurrentThread(const char* deviceUniqueIdUTF8) {
+  return webrtc::VideoCaptureFactory::Create(deviceUniqueIdUTF8);
+}
+
+int32_t VcmCapturer::StartCaptureOnCurrentThread(
+    webrtc::VideoCaptureCapability capability) {
+  return vcm_->StartCapture(capability);
+}
+
+int32_t VcmCapturer::StopCaptureOnCurrentThread() {
+  return vcm_->StopCapture();
+}
+
+void VcmCapturer::ReleaseOnCurrentThread() { vcm_ = nullptr; }
+
+VcmCapturer* VcmCapturer::Create(size_t width, size_t height, size_t target_fps,
+                                 const VideoDevice& device) {
+  std::unique_ptr<VcmCapturer> vcm_capturer(new VcmCapturer());
+  if (!vcm_capturer->Init(width, height, target_fps, device)) {
+    RTC_LOG(LS_WARNING) << "Failed to create VcmCapturer(w = " << width
+                        << ", h = " << height << ", fps = " << target_fps
+                        << ", device = " << device.name << ")";
+    return nullptr;
+  }
+  return vcm_capturer.release();
+}
+
+void VcmCapturer::Destroy() {
+  if (!vcm_) {
+    return;
+  }
+  thread_->Invoke<int32_t>(RTC_FROM_HERE,
+                           [this] { return StopCaptureOnCurrentThread(); });
+  vcm_->DeRegisterCaptureDataCallback();
+  thread_->Invoke<void>(RTC_FROM_HERE,
+                        [this] { return ReleaseOnCurrentThread(); });
+}
+
+VcmCapturer::~VcmCapturer() { Destroy(); }
+
+void VcmCapturer::OnFrame(const webrtc::VideoFrame& frame) {
+  webrtc::test::TestVideoCapturer::OnFrame(frame);
+}
 }  // namespace strtc
\ No newline at end of file
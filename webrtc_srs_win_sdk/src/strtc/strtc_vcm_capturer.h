@@ -2,27 +2,68 @@
 #define STRTC_VCM_CAPTURER_H_
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "api/scoped_refptr.h"
 #include "modules/video_capture/video_capture.h"
 #include "rtc_base/thread.h"
+#include "strtc_video_device_registry.h"
 #include "test/test_video_capturer.h"
 
 namespace strtc {
+// The capture mode picked for a request and what it costs to turn it into
+// the requested I420 frames.
+struct CaptureFormat {
+  // VideoDevice::id, empty when the device is not known yet.
+  std::string device_id;
+  webrtc::VideoCaptureCapability capability;
+  // Name of capability.videoType, "MJPEG", "YUY2", ...
+  std::string video_type;
+  // Native format -> I420 in VideoCaptureImpl (libyuv::ConvertToI420).
+  // 0 copies, 1 repacks, 2 converts color, 3 decodes.
+  int conversion_cost = 0;
+  // Weighted pixels per second spent on conversion and scaling, what
+  // SelectCaptureFormat() minimizes.
+  int64_t total_cost = 0;
+  // The mode is larger than requested and scaled down by the capturer.
+  bool scaled = false;
+  // Smaller or slower than requested.
+  bool degraded = false;
+  // "MJPEG 1280x720@30 -> I420 (decode) -> 640x360@25", for logs.
+  std::string path;
+
+  // "copy", "repack", "convert" or "decode".
+  const char* conversion() const;
+};
+
 class VcmCapturer : public webrtc::test::TestVideoCapturer,
                     public rtc::VideoSinkInterface<webrtc::VideoFrame> {
  public:
+  // Opens `device` with the mode picked from its cached capabilities, no
+  // device enumeration involved.
   static VcmCapturer* Create(size_t width, size_t height, size_t target_fps,
-                             size_t capture_device_index);
+                             const VideoDevice& device);
   virtual ~VcmCapturer();
 
   void OnFrame(const webrtc::VideoFrame& frame) override;
 
+  const CaptureFormat& capture_format() const { return capture_format_; }
+
+  // Picks the cheapest of `capabilities` that still delivers width x height
+  // at target_fps. Modes that fall short lose first, the rest are ranked by
+  // total cost: every captured pixel is converted to I420, weighted by the
+  // conversion, and scaled down to the request when larger, at the mode's
+  // frame rate. A 640x480 YUY2 mode thus beats a 1920x1080 I420 one for a
+  // 640x480 request. False without a usable capability.
+  static bool SelectCaptureFormat(
+      const std::vector<webrtc::VideoCaptureCapability>& capabilities,
+      int width, int height, int target_fps, CaptureFormat* format);
+
  private:
   VcmCapturer();
   bool Init(size_t width, size_t height, size_t target_fps,
-            size_t capture_device_index);
+            const VideoDevice& device);
   void Destroy();
 
   rtc::scoped_refptr<webrtc::VideoCaptureModule> CreateDeviceOnCurrentThread(
@@ -34,6 +75,7 @@ class VcmCapturer : public webrtc::test::TestVideoCapturer,
  private:
   rtc::scoped_refptr<webrtc::VideoCaptureModule> vcm_;
   webrtc::VideoCaptureCapability capability_;
+  CaptureFormat capture_format_;
 
   std::unique_ptr<rtc::Thread> thread_;
 };
@@ -0,0 +1,223 @@
+#include "strtc_video_compositor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+#include "rtc_base/logging.h"
+#include "rtc_base/time_utils.h"
+#include "third_party/libyuv/include/libyuv/planar_functions.h"
+
+namespace strtc {
+VideoCompositor::Tile::Tile(int id) : id(id), rendered(0) {}
+
+void VideoCompositor::Tile::OnFrame(const webrtc::VideoFrame& frame) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (framerate_.ShouldDropFrame(rtc::TimeNanos())) {
+      ++capped_;
+      return;
+    }
+  }
+  mailbox.Put(frame);
+}
+
+void VideoCompositor::Tile::SetMaxFps(int max_fps) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  framerate_.SetMaxFramerate(max_fps > 0
+                                 ? max_fps
+                                 : std::numeric_limits<double>::max());
+}
+
+VideoTileStats VideoCompositor::Tile::GetStats() {
+  VideoTileStats stats;
+  stats.tile = id;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.capped = capped_;
+  }
+  // Capped frames never reach the mailbox.
+  stats.received = mailbox.received() + stats.capped;
+  stats.dropped = mailbox.dropped();
+  stats.rendered = rendered;
+  return stats;
+}
+
+VideoCompositor::VideoCompositor(std::unique_ptr<VideoRenderSurface> surface,
+                                 int width, int height)
+    : surface_(std::move(surface)),
+      width_(width),
+      height_(height),
+      stride_(width * 4),
+      canvas_(static_cast<size_t>(width) * height * 4, 0) {
+  thread_ = std::thread([this]() { Run(); });
+}
+
+VideoCompositor::~VideoCompositor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+  }
+  cond_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+rtc::VideoSinkInterface<webrtc::VideoFrame>* VideoCompositor::AddTile(
+    int tile, int x, int y, int width, int height, int max_fps) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::unique_ptr<Tile>& entry = tiles_[tile];
+  if (!entry) {
+    entry.reset(new Tile(tile));
+  } else {
+    Clear(entry->x, entry->y, entry->width, entry->height);
+  }
+  // Clip to the canvas.
+  entry->x = std::max(0, std::min(x, width_));
+  entry->y = std::max(0, std::min(y, height_));
+  entry->width = std::max(0, std::min(width, width_ - entry->x));
+  entry->height = std::max(0, std::min(height, height_ - entry->y));
+  entry->dirty = true;
+  changed_ = true;
+  entry->SetMaxFps(max_fps);
+  return entry.get();
+}
+
+void VideoCompositor::RemoveTile(int tile) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = tiles_.find(tile);
+  if (it == tiles_.end()) {
+    return;
+  }
+  it->second->mailbox.Close();
+  Clear(it->second->x, it->second->y, it->second->width, it->second->height);
+  tiles_.erase(it);
+  changed_ = true;
+}
+
+void VideoCompositor::GetSize(int* width, int* height) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  *width = width_;
+  *height = height_;
+}
+
+std::vector<VideoTileStats> VideoCompositor::GetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<VideoTileStats> stats;
+  for (auto& it : tiles_) {
+    stats.push_back(it.second->GetStats());
+  }
+  return stats;
+}
+
+void VideoCompositor::Run() {
+  const int interval_ms = std::max(1, surface_->RefreshIntervalMs());
+  // Copy of the canvas handed to the surface. Presenting can block on the
+  // display, so it runs without mutex_ and never stalls AddTile() or
+  // RemoveTile() on the caller's thread.
+  std::vector<uint8_t> presented;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopped_) {
+    int64_t start_ms = rtc::TimeMillis();
+
+    lock.unlock();
+    int target_width = 0;
+    int target_height = 0;
+    surface_->GetTargetSize(&target_width, &target_height);
+    lock.lock();
+    if (target_width > 0 && target_height > 0 &&
+        (target_width != width_ || target_height != height_)) {
+      Resize(target_width, target_height);
+    }
+
+    Compose();
+    if (changed_) {
+      // Tiles are only written under mutex_, the copy is consistent.
+      presented.assign(canvas_.begin(), canvas_.end());
+      // Changes made while presenting are presented next time.
+      changed_ = false;
+      int stride = stride_;
+      int width = width_;
+      int height = height_;
+      lock.unlock();
+      surface_->Present(presented.data(), stride, width, height);
+      lock.lock();
+    }
+    int64_t wait_ms = interval_ms - (rtc::TimeMillis() - start_ms);
+    if (wait_ms > 0) {
+      cond_.wait_for(lock, std::chrono::milliseconds(wait_ms),
+                     [this]() { return stopped_; });
+    }
+  }
+}
+
+void VideoCompositor::Compose() {
+  for (auto& it : tiles_) {
+    Tile* tile = it.second.get();
+    if (tile->width <= 0 || tile->height <= 0) {
+      continue;
+    }
+    absl::optional<webrtc::VideoFrame> frame = tile->mailbox.Take();
+    if (!frame) {
+      continue;
+    }
+
+    const uint8_t* argb = nullptr;
+    int stride = 0;
+    int width = 0;
+    int height = 0;
+    if (!tile->converter.ConvertToARGB(*frame, tile->width, tile->height,
+                                       &argb, &stride, &width, &height)) {
+      continue;
+    }
+    // Letterbox inside the tile, the bars only need clearing when the image
+    // size changes.
+    if (tile->dirty || width != tile->image_width ||
+        height != tile->image_height) {
+      Clear(tile->x, tile->y, tile->width, tile->height);
+      tile->image_width = width;
+      tile->image_height = height;
+    }
+    int x = tile->x + (tile->width - width) / 2;
+    int y = tile->y + (tile->height - height) / 2;
+    libyuv::ARGBCopy(argb, stride, &canvas_[y * stride_ + x * 4], stride_,
+                     width, height);
+    tile->dirty = false;
+    ++tile->rendered;
+    changed_ = true;
+  }
+}
+
+void VideoCompositor::Resize(int width, int height) {
+  // Edges are scaled rather than sizes, so neighbouring tiles stay flush.
+  auto scale = [](int value, int to, int from) {
+    return static_cast<int>(static_cast<int64_t>(value) * to / from);
+  };
+  for (auto& it : tiles_) {
+    if (width_ <= 0 || height_ <= 0) {
+      break;
+    }
+    Tile* tile = it.second.get();
+    int right = scale(tile->x + tile->width, width, width_);
+    int bottom = scale(tile->y + tile->height, height, height_);
+    tile->x = scale(tile->x, width, width_);
+    tile->y = scale(tile->y, height, height_);
+    tile->width = right - tile->x;
+    tile->height = bottom - tile->y;
+    tile->dirty = true;
+  }
+  width_ = width;
+  height_ = height;
+  stride_ = width * 4;
+  canvas_.assign(static_cast<size_t>(width) * height * 4, 0);
+  changed_ = true;
+}
+
+void VideoCompositor::Clear(int x, int y, int width, int height) {
+  if (width <= 0 || height <= 0) {
+    return;
+  }
+  libyuv::ARGBRect(canvas_.data(), stride_, x, y, width, height, 0xff000000);
+}
+}  // namespace strtc
@@ -0,0 +1,103 @@
+#ifndef STRTC_VIDEO_COMPOSITOR_H_
+#define STRTC_VIDEO_COMPOSITOR_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "api/video/video_frame.h"
+#include "api/video/video_sink_interface.h"
+#include "common_video/framerate_controller.h"
+#include "strtc_common_define.h"
+#include "strtc_video_frame_converter.h"
+#include "strtc_video_frame_mailbox.h"
+#include "strtc_video_render_surface.h"
+
+namespace strtc {
+// Draws any number of streams into tiles of one ARGB canvas and presents the
+// canvas once per surface refresh interval. Each tile is a video sink that
+// only hands its frame over on the caller's thread, scaling, conversion and
+// presentation run on the compositor thread.
+class VideoCompositor {
+ public:
+  // `width` x `height` is the initial canvas size. Once the surface reports a
+  // target size the canvas follows it, and the tiles are scaled with it so
+  // they keep their place in the layout.
+  VideoCompositor(std::unique_ptr<VideoRenderSurface> surface, int width,
+                  int height);
+  ~VideoCompositor();
+
+  // Adds or moves tile `tile` to the canvas rectangle x, y, width, height.
+  // Frames above `max_fps` are dropped on arrival, 0 means no cap. The sink
+  // is owned by the compositor and valid until RemoveTile(), detach it from
+  // its track before.
+  rtc::VideoSinkInterface<webrtc::VideoFrame>* AddTile(int tile, int x, int y,
+                                                       int width, int height,
+                                                       int max_fps);
+  void RemoveTile(int tile);
+
+  void GetSize(int* width, int* height);
+  std::vector<VideoTileStats> GetStats();
+
+ private:
+  class Tile : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
+   public:
+    explicit Tile(int id);
+
+    void OnFrame(const webrtc::VideoFrame& frame) override;
+
+    void SetMaxFps(int max_fps);
+    VideoTileStats GetStats();
+
+    const int id;
+    // Guarded by the compositor mutex.
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    // The letterbox bars need clearing before the next image is drawn.
+    bool dirty = true;
+    int image_width = 0;
+    int image_height = 0;
+
+    // Only used on the compositor thread.
+    VideoFrameConverter converter;
+    VideoFrameMailbox mailbox;
+    std::atomic<int64_t> rendered;
+
+   private:
+    std::mutex mutex_;
+    webrtc::FramerateController framerate_;
+    int64_t capped_ = 0;
+  };
+
+  void Run();
+  // Draws the frames the tiles received since the last call.
+  void Compose();
+  void Resize(int width, int height);
+  void Clear(int x, int y, int width, int height);
+
+ private:
+  // Only used on the compositor thread.
+  std::unique_ptr<VideoRenderSurface> surface_;
+
+  std::mutex mutex_;
+  int width_;
+  int height_;
+  int stride_;
+  std::condition_variable cond_;
+  bool stopped_ = false;
+  std::map<int, std::unique_ptr<Tile>> tiles_;
+  // Written with mutex_ held.
+  std::vector<uint8_t> canvas_;
+  // The canvas differs from what was last presented.
+  bool changed_ = true;
+
+  std::thread thread_;
+};
+}  // namespace strtc
+#endif  // STRTC_VIDEO_COMPOSITOR_H_
@@ -0,0 +1,171 @@
+#include "strtc_video_device_registry.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "modules/video_capture/video_capture_factory.h"
+#include "rtc_base/logging.h"
+
+namespace strtc {
+constexpr int kDevicePollIntervalMs = 2000;
+
+std::vector<VideoDevice> VcmVideoDeviceBackend::ListDevices() {
+  std::vector<VideoDevice> devices;
+  if (!device_info_) {
+    device_info_.reset(webrtc::VideoCaptureFactory::CreateDeviceInfo());
+    if (!device_info_) {
+      return devices;
+    }
+  }
+
+  uint32_t num_devices = device_info_->NumberOfDevices();
+  for (uint32_t i = 0; i < num_devices; ++i) {
+    char device_name[webrtc::kVideoCaptureDeviceNameLength] = {0};
+    char unique_name[webrtc::kVideoCaptureUniqueNameLength] = {0};
+    if (device_info_->GetDeviceName(i, device_name, sizeof(device_name),
+                                    unique_name, sizeof(unique_name)) != 0) {
+      continue;
+    }
+    VideoDevice device;
+    device.id = unique_name;
+    device.name = device_name;
+    devices.push_back(std::move(device));
+  }
+  return devices;
+}
+
+std::vector<webrtc::VideoCaptureCapability>
+VcmVideoDeviceBackend::GetCapabilities(const std::string& id) {
+  std::vector<webrtc::VideoCaptureCapability> capabilities;
+  if (!device_info_) {
+    return capabilities;
+  }
+  int32_t num_capabilities = device_info_->NumberOfCapabilities(id.c_str());
+  for (int32_t i = 0; i < num_capabilities; ++i) {
+    webrtc::VideoCaptureCapability capability;
+    if (device_info_->GetCapability(id.c_str(), i, capability) == 0) {
+      capabilities.push_back(capability);
+    }
+  }
+  return capabilities;
+}
+
+void VcmVideoDeviceBackend::Close() {
+  device_info_.reset();
+}
+
+VideoDeviceRegistry* VideoDeviceRegistry::Instance() {
+  static VideoDeviceRegistry* registry = new VideoDeviceRegistry(
+      std::make_unique<VcmVideoDeviceBackend>(), kDevicePollIntervalMs);
+  return registry;
+}
+
+VideoDeviceRegistry::VideoDeviceRegistry(
+    std::unique_ptr<VideoDeviceBackend> backend, int poll_interval_ms)
+    : backend_(std::move(backend)), poll_interval_ms_(poll_interval_ms) {
+  thread_ = std::thread([this]() { Run(); });
+}
+
+VideoDeviceRegistry::~VideoDeviceRegistry() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+  }
+  cond_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+std::vector<VideoDevice> VideoDeviceRegistry::GetDevices() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this]() { return enumerated_ || stopped_; });
+  return devices_;
+}
+
+bool VideoDeviceRegistry::GetDevice(const std::string& id,
+                                    VideoDevice* device) {
+  std::vector<VideoDevice> devices = GetDevices();
+  auto it = std::find_if(
+      devices.begin(), devices.end(),
+      [&id](const VideoDevice& device) { return device.id == id; });
+  if (it == devices.end()) {
+    return false;
+  }
+  *device = *it;
+  return true;
+}
+
+int VideoDeviceRegistry::AddListener(DevicesCallback callback) {
+  std::lock_guard<std::mutex> lock(listener_mutex_);
+  int listener_id = next_listener_id_++;
+  listeners_[listener_id] = std::move(callback);
+  return listener_id;
+}
+
+void VideoDeviceRegistry::RemoveListener(int listener_id) {
+  std::lock_guard<std::mutex> lock(listener_mutex_);
+  listeners_.erase(listener_id);
+}
+
+void VideoDeviceRegistry::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopped_) {
+    lock.unlock();
+    bool changed = Refresh();
+    lock.lock();
+
+    if (!enumerated_) {
+      enumerated_ = true;
+      cond_.notify_all();
+    } else if (changed) {
+      std::vector<VideoDevice> devices = devices_;
+      lock.unlock();
+      std::lock_guard<std::mutex> listener_lock(listener_mutex_);
+      for (auto& it : listeners_) {
+        it.second(devices);
+      }
+      lock.lock();
+    }
+
+    cond_.wait_for(lock, std::chrono::milliseconds(poll_interval_ms_),
+                   [this]() { return stopped_; });
+  }
+  lock.unlock();
+  backend_->Close();
+}
+
+bool VideoDeviceRegistry::Refresh() {
+  std::vector<VideoDevice> devices = backend_->ListDevices();
+
+  std::vector<VideoDevice> cached;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cached = devices_;
+  }
+  bool changed = devices.size() != cached.size();
+  for (size_t i = 0; i < devices.size(); ++i) {
+    auto it = std::find_if(cached.begin(), cached.end(),
+                           [&devices, i](const VideoDevice& device) {
+                             return device.id == devices[i].id;
+                           });
+    if (it != cached.end()) {
+      devices[i].capabilities = std::move(it->capabilities);
+      changed |= it != cached.begin() + i;
+      continue;
+    }
+    devices[i].capabilities = backend_->GetCapabilities(devices[i].id);
+    changed = true;
+    RTC_LOG(LS_INFO) << __FUNCTION__ << " video device " << devices[i].name
+                     << " modes: " << devices[i].capabilities.size();
+  }
+  if (!changed) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  devices_ = std::move(devices);
+  RTC_LOG(LS_INFO) << __FUNCTION__ << " video devices: " << devices_.size();
+  return true;
+}
+}  // namespace strtc
@@ -0,0 +1,97 @@
+#ifndef STRTC_VIDEO_DEVICE_REGISTRY_H_
+#define STRTC_VIDEO_DEVICE_REGISTRY_H_
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "modules/video_capture/video_capture.h"
+
+namespace strtc {
+struct VideoDevice {
+  // Unique name of the capture module, stable across plug/unplug.
+  std::string id;
+  std::string name;
+  std::vector<webrtc::VideoCaptureCapability> capabilities;
+};
+
+// Where the registry gets its devices from. Only called on the registry's
+// thread.
+class VideoDeviceBackend {
+ public:
+  virtual ~VideoDeviceBackend() = default;
+  // Ids and names, without capabilities.
+  virtual std::vector<VideoDevice> ListDevices() = 0;
+  virtual std::vector<webrtc::VideoCaptureCapability> GetCapabilities(
+      const std::string& id) = 0;
+  // Last call, before the registry's thread exits.
+  virtual void Close() {}
+};
+
+// The capture module's DeviceInfo, created on first use so it lives on the
+// thread it is called from (DirectShow needs COM set up there).
+class VcmVideoDeviceBackend : public VideoDeviceBackend {
+ public:
+  std::vector<VideoDevice> ListDevices() override;
+  std::vector<webrtc::VideoCaptureCapability> GetCapabilities(
+      const std::string& id) override;
+  void Close() override;
+
+ private:
+  std::unique_ptr<webrtc::VideoCaptureModule::DeviceInfo> device_info_;
+};
+
+// Enumerates the cameras once, caches their names and capabilities and
+// polls the backend for plugged and unplugged devices. Capabilities are
+// only queried for devices that were not seen before.
+class VideoDeviceRegistry {
+ public:
+  using DevicesCallback =
+      std::function<void(const std::vector<VideoDevice>& devices)>;
+
+  // Registry over the capture module, shared by every engine.
+  static VideoDeviceRegistry* Instance();
+
+  VideoDeviceRegistry(std::unique_ptr<VideoDeviceBackend> backend,
+                      int poll_interval_ms);
+  ~VideoDeviceRegistry();
+
+  // Blocks until the first enumeration finished.
+  std::vector<VideoDevice> GetDevices();
+  bool GetDevice(const std::string& id, VideoDevice* device);
+
+  // `callback` runs on the registry thread after every change and must not
+  // call back into the registry. Returns an id for RemoveListener().
+  int AddListener(DevicesCallback callback);
+  // After it returns the callback is not running and not called again.
+  void RemoveListener(int listener_id);
+
+ private:
+  void Run();
+  // Returns true when the device list changed.
+  bool Refresh();
+
+ private:
+  const std::unique_ptr<VideoDeviceBackend> backend_;
+  const int poll_interval_ms_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  bool enumerated_ = false;
+  bool stopped_ = false;
+  std::vector<VideoDevice> devices_;
+
+  // Held while callbacks run, so RemoveListener() can wait for them.
+  std::mutex listener_mutex_;
+  int next_listener_id_ = 0;
+  std::map<int, DevicesCallback> listeners_;
+
+  std::thread thread_;
+};
+}  // namespace strtc
+#endif  // STRTC_VIDEO_DEVICE_REGISTRY_H_
@@ -0,0 +1,155 @@
+#include "strtc_video_frame_converter.h"
+
+#include <algorithm>
+
+#include "third_party/libyuv/include/libyuv/convert_argb.h"
+#include "third_party/libyuv/include/libyuv/rotate.h"
+#include "third_party/libyuv/include/libyuv/scale.h"
+
+namespace strtc {
+VideoFrameConverter::VideoFrameConverter() : allocations_(0) {}
+
+bool VideoFrameConverter::ConvertToARGB(const webrtc::VideoFrame& frame,
+                                        int target_width, int target_height,
+                                        const uint8_t** argb, int* stride,
+                                        int* width, int* height) {
+  rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer =
+      frame.video_frame_buffer();
+  if (buffer->type() == webrtc::VideoFrameBuffer::Type::kNative) {
+    webrtc::VideoFrameBuffer::Type types[] = {
+        webrtc::VideoFrameBuffer::Type::kI420,
+        webrtc::VideoFrameBuffer::Type::kNV12};
+    rtc::scoped_refptr<webrtc::VideoFrameBuffer> mapped =
+        buffer->GetMappedFrameBuffer(types);
+    if (mapped) {
+      buffer = mapped;
+    }
+  }
+
+  webrtc::VideoRotation rotation = frame.rotation();
+  bool transposed = rotation == webrtc::kVideoRotation_90 ||
+                    rotation == webrtc::kVideoRotation_270;
+  int out_width = transposed ? buffer->height() : buffer->width();
+  int out_height = transposed ? buffer->width() : buffer->height();
+
+  // Fit into the target, keeping the aspect ratio and even dimensions.
+  if (target_width > 0 && target_height > 0 &&
+      (out_width > target_width || out_height > target_height)) {
+    double scale = std::min(static_cast<double>(target_width) / out_width,
+                            static_cast<double>(target_height) / out_height);
+    out_width = std::max(2, static_cast<int>(out_width * scale) & ~1);
+    out_height = std::max(2, static_cast<int>(out_height * scale) & ~1);
+  }
+  // Size before rotation.
+  int scaled_width = transposed ? out_height : out_width;
+  int scaled_height = transposed ? out_width : out_height;
+  bool scaled = scaled_width != buffer->width() ||
+                scaled_height != buffer->height();
+
+  uint8_t* dst = EnsureARGB(out_width, out_height);
+  int dst_stride = out_width * 4;
+  *argb = dst;
+  *stride = dst_stride;
+  *width = out_width;
+  *height = out_height;
+
+  rtc::scoped_refptr<webrtc::I420BufferInterface> converted;
+  const webrtc::I420BufferInterface* i420 = nullptr;
+  if (buffer->type() == webrtc::VideoFrameBuffer::Type::kNV12) {
+    const webrtc::NV12BufferInterface* nv12 = buffer->GetNV12();
+    if (scaled) {
+      webrtc::NV12Buffer* nv12_scaled =
+          EnsureNV12(&scaled_nv12_, scaled_width, scaled_height);
+      libyuv::NV12Scale(nv12->DataY(), nv12->StrideY(), nv12->DataUV(),
+                        nv12->StrideUV(), nv12->width(), nv12->height(),
+                        nv12_scaled->MutableDataY(), nv12_scaled->StrideY(),
+                        nv12_scaled->MutableDataUV(), nv12_scaled->StrideUV(),
+                        scaled_width, scaled_height, libyuv::kFilterBox);
+      nv12 = nv12_scaled;
+    }
+    if (rotation == webrtc::kVideoRotation_0) {
+      libyuv::NV12ToARGB(nv12->DataY(), nv12->StrideY(), nv12->DataUV(),
+                         nv12->StrideUV(), dst, dst_stride, out_width,
+                         out_height);
+      return true;
+    }
+    webrtc::I420Buffer* rotated = EnsureI420(&rotated_, out_width, out_height);
+    libyuv::NV12ToI420Rotate(
+        nv12->DataY(), nv12->StrideY(), nv12->DataUV(), nv12->StrideUV(),
+        rotated->MutableDataY(), rotated->StrideY(), rotated->MutableDataU(),
+        rotated->StrideU(), rotated->MutableDataV(), rotated->StrideV(),
+        nv12->width(), nv12->height(),
+        static_cast<libyuv::RotationMode>(rotation));
+    i420 = rotated;
+  } else {
+    i420 = buffer->GetI420();
+    if (!i420) {
+      converted = buffer->ToI420();
+      ++allocations_;
+      if (!converted) {
+        return false;
+      }
+      i420 = converted.get();
+    }
+    if (scaled) {
+      webrtc::I420Buffer* i420_scaled =
+          EnsureI420(&scaled_i420_, scaled_width, scaled_height);
+      libyuv::I420Scale(i420->DataY(), i420->StrideY(), i420->DataU(),
+                        i420->StrideU(), i420->DataV(), i420->StrideV(),
+                        i420->width(), i420->height(),
+                        i420_scaled->MutableDataY(), i420_scaled->StrideY(),
+                        i420_scaled->MutableDataU(), i420_scaled->StrideU(),
+                        i420_scaled->MutableDataV(), i420_scaled->StrideV(),
+                        scaled_width, scaled_height, libyuv::kFilterBox);
+      i420 = i420_scaled;
+    }
+    if (rotation != webrtc::kVideoRotation_0) {
+      webrtc::I420Buffer* rotated =
+          EnsureI420(&rotated_, out_width, out_height);
+      libyuv::I420Rotate(i420->DataY(), i420->StrideY(), i420->DataU(),
+                         i420->StrideU(), i420->DataV(), i420->StrideV(),
+                         rotated->MutableDataY(), rotated->StrideY(),
+                         rotated->MutableDataU(), rotated->StrideU(),
+                         rotated->MutableDataV(), rotated->StrideV(),
+                         i420->width(), i420->height(),
+                         static_cast<libyuv::RotationMode>(rotation));
+      i420 = rotated;
+    }
+  }
+
+  libyuv::I420ToARGB(i420->DataY(), i420->StrideY(), i420->DataU(),
+                     i420->StrideU(), i420->DataV(), i420->StrideV(), dst,
+                     dst_stride, out_width, out_height);
+  return true;
+}
+
+uint8_t* VideoFrameConverter::EnsureARGB(int width, int height) {
+  size_t size = static_cast<size_t>(width) * height * 4;
+  if (size > argb_capacity_) {
+    argb_.reset(new uint8_t[size]);
+    argb_capacity_ = size;
+    ++allocations_;
+  }
+  return argb_.get();
+}
+
+// The buffers never leave the converter, so one that fits can be written
+// again right away.
+webrtc::I420Buffer* VideoFrameConverter::EnsureI420(
+    rtc::scoped_refptr<webrtc::I420Buffer>* slot, int width, int height) {
+  if (!*slot || (*slot)->width() != width || (*slot)->height() != height) {
+    *slot = webrtc::I420Buffer::Create(width, height);
+    ++allocations_;
+  }
+  return slot->get();
+}
+
+webrtc::NV12Buffer* VideoFrameConverter::EnsureNV12(
+    rtc::scoped_refptr<webrtc::NV12Buffer>* slot, int width, int height) {
+  if (!*slot || (*slot)->width() != width || (*slot)->height() != height) {
+    *slot = webrtc::NV12Buffer::Create(width, height);
+    ++allocations_;
+  }
+  return slot->get();
+}
+}  // namespace strtc
@@ -0,0 +1,57 @@
+#ifndef STRTC_VIDEO_FRAME_CONVERTER_H_
+#define STRTC_VIDEO_FRAME_CONVERTER_H_
+
+#include <atomic>
+#include <memory>
+
+#include "api/video/i420_buffer.h"
+#include "api/video/nv12_buffer.h"
+#include "api/video/video_frame.h"
+
+namespace strtc {
+// Converts frames to ARGB with their rotation applied, reusing its buffers
+// from frame to frame. Frames larger than the target are scaled down first,
+// so rotation and color conversion only touch the pixels that are shown.
+// I420 and NV12 frames, and native frames that map to either, are converted
+// without a per-frame allocation. Not thread safe, meant to be owned by one
+// render thread. test/strtc_video_frame_converter_benchmark.cc compares it
+// with converting at full resolution.
+class VideoFrameConverter {
+ public:
+  VideoFrameConverter();
+
+  // `argb` stays valid until the next call. The image keeps the aspect
+  // ratio and fits into target_width x target_height, a target of 0 x 0
+  // keeps the frame size. Frames are never scaled up.
+  bool ConvertToARGB(const webrtc::VideoFrame& frame, int target_width,
+                     int target_height, const uint8_t** argb, int* stride,
+                     int* width, int* height);
+
+  // Heap allocations made by the conversion so far: ARGB growth, scale or
+  // rotation buffers created for a new size and ToI420() fallbacks.
+  // Readable from any thread.
+  int64_t allocations() const { return allocations_; }
+
+ private:
+  uint8_t* EnsureARGB(int width, int height);
+  webrtc::I420Buffer* EnsureI420(rtc::scoped_refptr<webrtc::I420Buffer>* slot,
+                                 int width, int height);
+  webrtc::NV12Buffer* EnsureNV12(rtc::scoped_refptr<webrtc::NV12Buffer>* slot,
+                                 int width, int height);
+
+ private:
+  // One buffer per conversion step, kept while its size holds. A shared
+  // pool would purge the other steps' buffers on every size or format
+  // change, e.g. between the scaled and the transposed rotated size.
+  rtc::scoped_refptr<webrtc::NV12Buffer> scaled_nv12_;
+  rtc::scoped_refptr<webrtc::I420Buffer> scaled_i420_;
+  rtc::scoped_refptr<webrtc::I420Buffer> rotated_;
+
+  // Only ever grows.
+  std::unique_ptr<uint8_t[]> argb_;
+  size_t argb_capacity_ = 0;
+
+  std::atomic<int64_t> allocations_;
+};
+}  // namespace strtc
+#endif  // STRTC_VIDEO_FRAME_CONVERTER_H_
@@ -0,0 +1,57 @@
+#include "strtc_video_frame_mailbox.h"
+
+#include <chrono>
+
+namespace strtc {
+bool VideoFrameMailbox::Put(const webrtc::VideoFrame& frame) {
+  bool replaced = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++received_;
+    if (closed_) {
+      ++dropped_;
+      return false;
+    }
+    if (frame_) {
+      ++dropped_;
+      replaced = true;
+    }
+    frame_ = frame;
+  }
+  cond_.notify_one();
+  return !replaced;
+}
+
+bool VideoFrameMailbox::Wait(int timeout_ms) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                 [this]() { return closed_ || frame_.has_value(); });
+  return !closed_;
+}
+
+absl::optional<webrtc::VideoFrame> VideoFrameMailbox::Take() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  absl::optional<webrtc::VideoFrame> frame = std::move(frame_);
+  frame_.reset();
+  return frame;
+}
+
+void VideoFrameMailbox::Close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    frame_.reset();
+  }
+  cond_.notify_all();
+}
+
+int64_t VideoFrameMailbox::received() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return received_;
+}
+
+int64_t VideoFrameMailbox::dropped() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return dropped_;
+}
+}  // namespace strtc
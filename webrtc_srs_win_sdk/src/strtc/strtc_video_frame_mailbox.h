@@ -0,0 +1,37 @@
+#ifndef STRTC_VIDEO_FRAME_MAILBOX_H_
+#define STRTC_VIDEO_FRAME_MAILBOX_H_
+
+#include <condition_variable>
+#include <mutex>
+
+#include "absl/types/optional.h"
+#include "api/video/video_frame.h"
+
+namespace strtc {
+// Single slot hand-off from a frame producer (decoder or capturer callback)
+// to a consumer thread. A new frame replaces one that was not taken yet, so
+// the producer never waits on the consumer.
+class VideoFrameMailbox {
+ public:
+  // Returns false when an unconsumed frame was replaced, i.e. dropped.
+  bool Put(const webrtc::VideoFrame& frame);
+  // Blocks until a frame can be taken or `timeout_ms` passed. Returns false
+  // once closed.
+  bool Wait(int timeout_ms);
+  absl::optional<webrtc::VideoFrame> Take();
+  // Wakes Wait() for good, later frames are dropped.
+  void Close();
+
+  int64_t received();
+  int64_t dropped();
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  absl::optional<webrtc::VideoFrame> frame_;
+  bool closed_ = false;
+  int64_t received_ = 0;
+  int64_t dropped_ = 0;
+};
+}  // namespace strtc
+#endif  // STRTC_VIDEO_FRAME_MAILBOX_H_
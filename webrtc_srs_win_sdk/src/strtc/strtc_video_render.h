@@ -1,51 +1,33 @@
 #ifndef STRTC_VIDEO_RENDER_H_
 #define STRTC_VIDEO_RENDER_H_
 
-#include "api/video/video_frame.h"
-#include "api/video/video_sink_interface.h"
+#include "strtc_video_render_pipeline.h"
 
 #if defined(WEBRTC_WIN)
 #include "rtc_base/win32.h"
 #endif  // WEBRTC_WIN
 
 namespace strtc {
-class VideoRenderer : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
+// Paints into the client area of a window with GDI, letterboxed.
+class GdiRenderSurface : public VideoRenderSurface {
  public:
-  VideoRenderer(HWND& wnd);
-  virtual ~VideoRenderer();
-
-  void Lock() { ::EnterCriticalSection(&buffer_lock_); }
-  void Unlock() { ::LeaveCriticalSection(&buffer_lock_); }
-
-  void OnFrame(const webrtc::VideoFrame& frame) override;
-
-  void OnPaint();
+  explicit GdiRenderSurface(HWND wnd);
 
-  const BITMAPINFO& bmi() const { return bmi_; }
-  const uint8_t* image() const { return image_.get(); }
-
- protected:
-  void SetSize(int width, int height);
-
-  enum {
-    SET_SIZE,
-    RENDER_FRAME,
-  };
+  int RefreshIntervalMs() override;
+  void GetTargetSize(int* width, int* height) override;
+  bool IsVisible() override;
+  void Present(const uint8_t* argb, int stride, int width,
+               int height) override;
 
+ private:
   HWND wnd_;
   BITMAPINFO bmi_;
-  std::unique_ptr<uint8_t[]> image_;
-  CRITICAL_SECTION buffer_lock_;
 };
 
-template <typename T>
-class AutoLock {
+class VideoRenderer : public VideoRenderPipeline {
  public:
-  explicit AutoLock(T* obj) : obj_(obj) { obj_->Lock(); }
-  ~AutoLock() { obj_->Unlock(); }
-
- protected:
-  T* obj_;
+  VideoRenderer(HWND& wnd);
+  virtual ~VideoRenderer();
 };
 }  // namespace strtc
-#endif  // STRTC_VIDEO_RENDER_H_
\ No newline at end of file
+#endif  // STRTC_VIDEO_RENDER_H_
@@ -0,0 +1,129 @@
+#include "strtc_video_render_pipeline.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "rtc_base/logging.h"
+#include "rtc_base/time_utils.h"
+
+namespace strtc {
+// How often the surface size and visibility are checked when no frames
+// arrive, e.g. while hidden.
+constexpr int kSurfaceCheckIntervalMs = 200;
+
+VideoRenderPipeline::VideoRenderPipeline(
+    std::unique_ptr<VideoRenderSurface> surface)
+    : surface_(std::move(surface)), rendered_(0) {
+  thread_ = std::thread([this]() { Run(); });
+}
+
+VideoRenderPipeline::~VideoRenderPipeline() {
+  mailbox_.Close();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  VideoRenderStats stats = GetStats();
+  RTC_LOG(LS_INFO) << __FUNCTION__ << " received: " << stats.received
+                   << " rendered: " << stats.rendered
+                   << " dropped: " << stats.dropped
+                   << " allocations: " << stats.allocations;
+}
+
+void VideoRenderPipeline::OnFrame(const webrtc::VideoFrame& frame) {
+  mailbox_.Put(frame);
+}
+
+rtc::VideoSinkWants VideoRenderPipeline::GetWants() {
+  std::lock_guard<std::mutex> lock(wants_mutex_);
+  return wants_;
+}
+
+void VideoRenderPipeline::SetWantsCallback(
+    std::function<void(const rtc::VideoSinkWants& wants)> callback) {
+  std::lock_guard<std::mutex> lock(wants_mutex_);
+  wants_callback_ = std::move(callback);
+}
+
+VideoRenderStats VideoRenderPipeline::GetStats() {
+  VideoRenderStats stats;
+  stats.received = mailbox_.received();
+  stats.rendered = rendered_;
+  stats.dropped = mailbox_.dropped();
+  stats.allocations = converter_.allocations();
+  return stats;
+}
+
+void VideoRenderPipeline::Run() {
+  const int interval_ms = std::max(1, surface_->RefreshIntervalMs());
+  int64_t next_present_ms = 0;
+  int64_t next_check_ms = 0;
+  while (mailbox_.Wait(kSurfaceCheckIntervalMs)) {
+    int64_t now_ms = rtc::TimeMillis();
+    if (now_ms >= next_check_ms) {
+      UpdateWants();
+      next_check_ms = now_ms + kSurfaceCheckIntervalMs;
+    }
+    if (now_ms < next_present_ms) {
+      // Frames arriving meanwhile replace the pending one.
+      std::this_thread::sleep_for(
+          std::chrono::milliseconds(next_present_ms - now_ms));
+    }
+
+    absl::optional<webrtc::VideoFrame> frame = mailbox_.Take();
+    if (!frame || !visible_) {
+      // Taken anyway so the mailbox does not keep a stale frame around.
+      continue;
+    }
+    Render(*frame);
+    ++rendered_;
+
+    // Keep the cadence unless we fell a whole interval behind.
+    now_ms = rtc::TimeMillis();
+    next_present_ms = std::max(next_present_ms + interval_ms, now_ms);
+  }
+}
+
+void VideoRenderPipeline::UpdateWants() {
+  int width = 0;
+  int height = 0;
+  surface_->GetTargetSize(&width, &height);
+  bool visible = surface_->IsVisible();
+  visible_ = visible;
+
+  rtc::VideoSinkWants wants;
+  if (width > 0 && height > 0) {
+    wants.max_pixel_count = width * height;
+    wants.target_pixel_count = width * height;
+  }
+  wants.max_framerate_fps =
+      visible ? 1000 / std::max(1, surface_->RefreshIntervalMs()) : 0;
+
+  std::lock_guard<std::mutex> lock(wants_mutex_);
+  if (wants.max_pixel_count == wants_.max_pixel_count &&
+      wants.target_pixel_count == wants_.target_pixel_count &&
+      wants.max_framerate_fps == wants_.max_framerate_fps) {
+    return;
+  }
+  RTC_LOG(LS_INFO) << __FUNCTION__ << " " << width << "x" << height
+                   << " fps: " << wants.max_framerate_fps;
+  wants_ = wants;
+  if (wants_callback_) {
+    wants_callback_(wants_);
+  }
+}
+
+void VideoRenderPipeline::Render(const webrtc::VideoFrame& video_frame) {
+  const uint8_t* argb = nullptr;
+  int stride = 0;
+  int width = 0;
+  int height = 0;
+  int target_width = 0;
+  int target_height = 0;
+  surface_->GetTargetSize(&target_width, &target_height);
+  if (!converter_.ConvertToARGB(video_frame, target_width, target_height,
+                                &argb, &stride, &width, &height)) {
+    return;
+  }
+  surface_->Present(argb, stride, width, height);
+}
+}  // namespace strtc
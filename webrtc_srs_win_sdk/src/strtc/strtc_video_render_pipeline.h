@@ -0,0 +1,74 @@
+#ifndef STRTC_VIDEO_RENDER_PIPELINE_H_
+#define STRTC_VIDEO_RENDER_PIPELINE_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "api/video/video_frame.h"
+#include "api/video/video_sink_interface.h"
+#include "api/video/video_source_interface.h"
+#include "strtc_video_frame_converter.h"
+#include "strtc_video_frame_mailbox.h"
+#include "strtc_video_render_surface.h"
+
+namespace strtc {
+struct VideoRenderStats {
+  int64_t received = 0;
+  int64_t rendered = 0;
+  // Replaced in the mailbox before the render thread got to them.
+  int64_t dropped = 0;
+  // Heap allocations made by the frame conversion, 0 per frame in steady
+  // state for I420 and NV12 input.
+  int64_t allocations = 0;
+};
+
+// Video sink that only hands the frame over on the caller's (decoder or
+// capturer) thread. Conversion and presentation run on an own render
+// thread, paced to the surface refresh interval, always on the latest frame.
+class VideoRenderPipeline : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
+ public:
+  explicit VideoRenderPipeline(std::unique_ptr<VideoRenderSurface> surface);
+  ~VideoRenderPipeline() override;
+
+  void OnFrame(const webrtc::VideoFrame& frame) override;
+
+  // What the surface can show: its pixel count, and its refresh rate or 0
+  // fps while hidden. Pass it to AddOrUpdateSink() so sources stop
+  // producing pixels nobody sees.
+  rtc::VideoSinkWants GetWants();
+  // Called on the render thread whenever GetWants() changes, e.g. on resize.
+  // Once SetWantsCallback() returns, the previous callback is not running
+  // and never runs again.
+  void SetWantsCallback(
+      std::function<void(const rtc::VideoSinkWants& wants)> callback);
+
+  VideoRenderStats GetStats();
+
+ private:
+  void Run();
+  void UpdateWants();
+  void Render(const webrtc::VideoFrame& frame);
+
+ private:
+  std::unique_ptr<VideoRenderSurface> surface_;
+  VideoFrameMailbox mailbox_;
+  std::atomic<int64_t> rendered_;
+
+  // Held while the callback runs.
+  std::mutex wants_mutex_;
+  rtc::VideoSinkWants wants_;
+  std::function<void(const rtc::VideoSinkWants& wants)> wants_callback_;
+
+  // Only used on the render thread.
+  VideoFrameConverter converter_;
+  // Last visibility seen by UpdateWants(), frames are not rendered while
+  // the surface is hidden.
+  bool visible_ = true;
+
+  std::thread thread_;
+};
+}  // namespace strtc
+#endif  // STRTC_VIDEO_RENDER_PIPELINE_H_
@@ -0,0 +1,60 @@
+#include "strtc_video_render_surface.h"
+
+#include <string.h>
+
+namespace strtc {
+MemoryRenderSurface::MemoryRenderSurface(int refresh_interval_ms)
+    : refresh_interval_ms_(refresh_interval_ms) {}
+
+void MemoryRenderSurface::GetTargetSize(int* width, int* height) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  *width = target_width_;
+  *height = target_height_;
+}
+
+void MemoryRenderSurface::SetTargetSize(int width, int height) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  target_width_ = width;
+  target_height_ = height;
+}
+
+bool MemoryRenderSurface::IsVisible() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return visible_;
+}
+
+void MemoryRenderSurface::SetVisible(bool visible) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  visible_ = visible;
+}
+
+void MemoryRenderSurface::Present(const uint8_t* argb, int stride, int width,
+                                  int height) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  image_.resize(static_cast<size_t>(width) * height * 4);
+  for (int y = 0; y < height; ++y) {
+    memcpy(&image_[static_cast<size_t>(y) * width * 4], argb + y * stride,
+           width * 4);
+  }
+  width_ = width;
+  height_ = height;
+  ++presented_;
+}
+
+int64_t MemoryRenderSurface::presented() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return presented_;
+}
+
+bool MemoryRenderSurface::GetImage(std::vector<uint8_t>* argb, int* width,
+                                   int* height) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (presented_ == 0) {
+    return false;
+  }
+  *argb = image_;
+  *width = width_;
+  *height = height_;
+  return true;
+}
+}  // namespace strtc
@@ -0,0 +1,63 @@
+#ifndef STRTC_VIDEO_RENDER_SURFACE_H_
+#define STRTC_VIDEO_RENDER_SURFACE_H_
+
+#include <stdint.h>
+
+#include <mutex>
+#include <vector>
+
+namespace strtc {
+// Where a VideoRenderPipeline shows its frames. Called on the render thread
+// only.
+class VideoRenderSurface {
+ public:
+  virtual ~VideoRenderSurface() = default;
+
+  // Time between two display refreshes. The render thread presents at most
+  // one frame per interval.
+  virtual int RefreshIntervalMs() { return 16; }
+  // Drawable area, frames are scaled down to fit it before conversion.
+  // 0 x 0 presents frames at their own size.
+  virtual void GetTargetSize(int* width, int* height) {
+    *width = 0;
+    *height = 0;
+  }
+  // A hidden surface asks its sources for no frames at all.
+  virtual bool IsVisible() { return true; }
+  // `argb` is width x height 32 bit pixels in libyuv ARGB order (B, G, R, A
+  // in memory), rows are `stride` bytes apart.
+  virtual void Present(const uint8_t* argb, int stride, int width,
+                       int height) = 0;
+};
+
+// Keeps a copy of the last presented image. For headless use and tests.
+class MemoryRenderSurface : public VideoRenderSurface {
+ public:
+  explicit MemoryRenderSurface(int refresh_interval_ms = 16);
+
+  int RefreshIntervalMs() override { return refresh_interval_ms_; }
+  void GetTargetSize(int* width, int* height) override;
+  bool IsVisible() override;
+  void Present(const uint8_t* argb, int stride, int width,
+               int height) override;
+
+  void SetTargetSize(int width, int height);
+  void SetVisible(bool visible);
+  int64_t presented();
+  // Tightly packed copy of the last image, false before the first Present.
+  bool GetImage(std::vector<uint8_t>* argb, int* width, int* height);
+
+ private:
+  const int refresh_interval_ms_;
+
+  std::mutex mutex_;
+  int target_width_ = 0;
+  int target_height_ = 0;
+  bool visible_ = true;
+  std::vector<uint8_t> image_;
+  int width_ = 0;
+  int height_ = 0;
+  int64_t presented_ = 0;
+};
+}  // namespace strtc
+#endif  // STRTC_VIDEO_RENDER_SURFACE_H_
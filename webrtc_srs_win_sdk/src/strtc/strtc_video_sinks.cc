@@ -0,0 +1,226 @@
+#include "strtc_video_sinks.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "rtc_base/logging.h"
+#include "rtc_base/time_utils.h"
+#include "third_party/libyuv/include/libyuv/planar_functions.h"
+
+namespace strtc {
+constexpr size_t kMaxKeptHashes = 10000;
+
+StrtcVideoSinkAdapter::StrtcVideoSinkAdapter(
+    std::shared_ptr<StrtcVideoSink> sink)
+    : sink_(sink) {}
+
+void StrtcVideoSinkAdapter::OnFrame(const webrtc::VideoFrame& frame) {
+  rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer =
+      frame.video_frame_buffer();
+  rtc::scoped_refptr<webrtc::I420BufferInterface> converted;
+  const webrtc::I420BufferInterface* i420 = buffer->GetI420();
+  if (!i420) {
+    converted = buffer->ToI420();
+    if (!converted) {
+      return;
+    }
+    i420 = converted.get();
+  }
+
+  VideoFrameData data;
+  data.width = i420->width();
+  data.height = i420->height();
+  data.rotation = frame.rotation();
+  data.dataY = i420->DataY();
+  data.dataU = i420->DataU();
+  data.dataV = i420->DataV();
+  data.strideY = i420->StrideY();
+  data.strideU = i420->StrideU();
+  data.strideV = i420->StrideV();
+  data.timestampUs = frame.timestamp_us();
+  data.rtpTimestamp = frame.timestamp();
+  data.ntpTimeMs = frame.ntp_time_ms();
+  sink_->onFrame(data);
+}
+
+void VideoSinkCounter::add(const VideoFrameData& frame) {
+  ++frames_;
+  if (frame.timestampUs > 0) {
+    latency_.add((rtc::TimeMicros() - frame.timestampUs) /
+                 rtc::kNumMicrosecsPerMillisec);
+  }
+}
+
+VideoSinkStats VideoSinkCounter::stats() const {
+  VideoSinkStats stats;
+  stats.frames = frames_;
+  stats.dropped = dropped_;
+  stats.latency = latency_.summary();
+  return stats;
+}
+
+std::shared_ptr<StrtcFileVideoSink> StrtcFileVideoSink::create(
+    const std::string& path, VideoFileFormat format, int maxQueuedFrames) {
+  webrtc::FileWrapper file = webrtc::FileWrapper::OpenWriteOnly(path);
+  if (!file.is_open()) {
+    RTC_LOG(LS_ERROR) << __FUNCTION__ << " open " << path << " failed";
+    return nullptr;
+  }
+  return std::make_shared<StrtcFileVideoSinkImpl>(
+      std::move(file), format, std::max(1, maxQueuedFrames));
+}
+
+StrtcFileVideoSinkImpl::StrtcFileVideoSinkImpl(webrtc::FileWrapper file,
+                                               VideoFileFormat format,
+                                               int max_queued_frames)
+    : file_(std::move(file)),
+      format_(format),
+      max_queued_frames_(max_queued_frames) {
+  thread_ = std::thread([this]() { run(); });
+}
+
+StrtcFileVideoSinkImpl::~StrtcFileVideoSinkImpl() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+  }
+  cond_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  file_.Close();
+}
+
+void StrtcFileVideoSinkImpl::onFrame(const VideoFrameData& frame) {
+  QueuedFrame queued;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (width_ == 0) {
+      width_ = frame.width;
+      height_ = frame.height;
+    }
+    if (queue_.size() >= max_queued_frames_ ||
+        (format_ == VIDEO_FILE_Y4M &&
+         (frame.width != width_ || frame.height != height_))) {
+      counter_.drop();
+      return;
+    }
+    if (!free_buffers_.empty()) {
+      queued.data.swap(free_buffers_.back());
+      free_buffers_.pop_back();
+    }
+  }
+
+  // Packed I420, the layout of both file formats.
+  int chroma_width = (frame.width + 1) / 2;
+  int chroma_height = (frame.height + 1) / 2;
+  size_t size_y = static_cast<size_t>(frame.width) * frame.height;
+  size_t size_uv = static_cast<size_t>(chroma_width) * chroma_height;
+  queued.width = frame.width;
+  queued.height = frame.height;
+  queued.data.resize(size_y + 2 * size_uv);
+  uint8_t* dst_y = queued.data.data();
+  uint8_t* dst_u = dst_y + size_y;
+  uint8_t* dst_v = dst_u + size_uv;
+  libyuv::I420Copy(frame.dataY, frame.strideY, frame.dataU, frame.strideU,
+                   frame.dataV, frame.strideV, dst_y, frame.width, dst_u,
+                   chroma_width, dst_v, chroma_width, frame.width,
+                   frame.height);
+  counter_.add(frame);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(std::move(queued));
+  }
+  cond_.notify_one();
+}
+
+void StrtcFileVideoSinkImpl::run() {
+  bool header_written = false;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cond_.wait(lock, [this]() { return stopped_ || !queue_.empty(); });
+    // Drains the queue before stopping.
+    if (queue_.empty()) {
+      return;
+    }
+    QueuedFrame frame = std::move(queue_.front());
+    queue_.pop_front();
+    lock.unlock();
+
+    if (format_ == VIDEO_FILE_Y4M) {
+      if (!header_written) {
+        char header[128];
+        int length = snprintf(header, sizeof(header),
+                              "YUV4MPEG2 W%d H%d F30:1 Ip A1:1 C420jpeg\n",
+                              frame.width, frame.height);
+        file_.Write(header, length);
+        header_written = true;
+      }
+      file_.Write("FRAME\n", 6);
+    }
+    if (!file_.Write(frame.data.data(), frame.data.size())) {
+      RTC_LOG(LS_ERROR) << __FUNCTION__ << " write failed";
+    }
+
+    lock.lock();
+    free_buffers_.push_back(std::move(frame.data));
+    if (free_buffers_.size() > max_queued_frames_) {
+      free_buffers_.pop_back();
+    }
+  }
+}
+
+std::shared_ptr<StrtcHashVideoSink> StrtcHashVideoSink::create() {
+  return std::make_shared<StrtcHashVideoSinkImpl>();
+}
+
+void StrtcHashVideoSinkImpl::onFrame(const VideoFrameData& frame) {
+  VideoFrameHash hash;
+  hash.timestampUs = frame.timestampUs;
+  hash.rtpTimestamp = frame.rtpTimestamp;
+  hash.width = frame.width;
+  hash.height = frame.height;
+  hash.hash = hashFrame(frame);
+  counter_.add(frame);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  hashes_.push_back(hash);
+  if (hashes_.size() > kMaxKeptHashes) {
+    hashes_.pop_front();
+  }
+}
+
+std::vector<VideoFrameHash> StrtcHashVideoSinkImpl::takeHashes() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<VideoFrameHash> hashes(hashes_.begin(), hashes_.end());
+  hashes_.clear();
+  return hashes;
+}
+
+uint64_t StrtcHashVideoSinkImpl::hashFrame(const VideoFrameData& frame) {
+  // Row by row, the stride padding differs between senders and receivers.
+  uint64_t hash = 14695981039346656037ULL;
+  auto hash_plane = [&hash](const uint8_t* data, int stride, int width,
+                            int height) {
+    for (int y = 0; y < height; ++y) {
+      const uint8_t* row = data + static_cast<ptrdiff_t>(y) * stride;
+      for (int x = 0; x < width; ++x) {
+        hash = (hash ^ row[x]) * 1099511628211ULL;
+      }
+    }
+  };
+  int chroma_width = (frame.width + 1) / 2;
+  int chroma_height = (frame.height + 1) / 2;
+  hash_plane(frame.dataY, frame.strideY, frame.width, frame.height);
+  hash_plane(frame.dataU, frame.strideU, chroma_width, chroma_height);
+  hash_plane(frame.dataV, frame.strideV, chroma_width, chroma_height);
+  return hash;
+}
+
+std::shared_ptr<StrtcNullVideoSink> StrtcNullVideoSink::create() {
+  return std::make_shared<StrtcNullVideoSinkImpl>();
+}
+}  // namespace strtc
@@ -0,0 +1,108 @@
+#ifndef STRTC_VIDEO_SINKS_H_
+#define STRTC_VIDEO_SINKS_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "api/video/video_frame.h"
+#include "api/video/video_sink_interface.h"
+#include "rtc_base/system/file_wrapper.h"
+#include "strtc_latency_histogram.h"
+#include "strtc_video_sink.h"
+
+namespace strtc {
+// Feeds a StrtcVideoSink from a webrtc video track.
+class StrtcVideoSinkAdapter
+    : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
+ public:
+  explicit StrtcVideoSinkAdapter(std::shared_ptr<StrtcVideoSink> sink);
+
+  void OnFrame(const webrtc::VideoFrame& frame) override;
+
+  StrtcVideoSink* sink() { return sink_.get(); }
+
+ private:
+  std::shared_ptr<StrtcVideoSink> sink_;
+};
+
+// Frame count and latency shared by the sinks below.
+class VideoSinkCounter {
+ public:
+  VideoSinkCounter() : frames_(0), dropped_(0) {}
+
+  void add(const VideoFrameData& frame);
+  void drop() { ++dropped_; }
+  VideoSinkStats stats() const;
+
+ private:
+  std::atomic<int64_t> frames_;
+  std::atomic<int64_t> dropped_;
+  LatencyHistogram latency_;
+};
+
+class StrtcFileVideoSinkImpl : public StrtcFileVideoSink {
+ public:
+  StrtcFileVideoSinkImpl(webrtc::FileWrapper file, VideoFileFormat format,
+                         int max_queued_frames);
+  ~StrtcFileVideoSinkImpl() override;
+
+  void onFrame(const VideoFrameData& frame) override;
+  VideoSinkStats getStats() override { return counter_.stats(); }
+
+ private:
+  struct QueuedFrame {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> data;
+  };
+
+  void run();
+
+ private:
+  webrtc::FileWrapper file_;
+  const VideoFileFormat format_;
+  const size_t max_queued_frames_;
+  VideoSinkCounter counter_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  bool stopped_ = false;
+  // Size of every Y4M frame, from the first one.
+  int width_ = 0;
+  int height_ = 0;
+  std::deque<QueuedFrame> queue_;
+  // Written frames come back here, so steady state does not allocate.
+  std::vector<std::vector<uint8_t>> free_buffers_;
+
+  std::thread thread_;
+};
+
+class StrtcHashVideoSinkImpl : public StrtcHashVideoSink {
+ public:
+  void onFrame(const VideoFrameData& frame) override;
+  VideoSinkStats getStats() override { return counter_.stats(); }
+  std::vector<VideoFrameHash> takeHashes() override;
+
+  static uint64_t hashFrame(const VideoFrameData& frame);
+
+ private:
+  VideoSinkCounter counter_;
+  std::mutex mutex_;
+  std::deque<VideoFrameHash> hashes_;
+};
+
+class StrtcNullVideoSinkImpl : public StrtcNullVideoSink {
+ public:
+  void onFrame(const VideoFrameData& frame) override { counter_.add(frame); }
+  VideoSinkStats getStats() override { return counter_.stats(); }
+
+ private:
+  VideoSinkCounter counter_;
+};
+}  // namespace strtc
+#endif  // STRTC_VIDEO_SINKS_H_
@@ -0,0 +1,283 @@
+#include "strtc_whip_signal.h"
+
+#include "absl/strings/match.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/string_encode.h"
+
+namespace strtc {
+constexpr int kDefaultSignalTimeoutMs = 5000;
+constexpr int kDefaultSignalConnTimeoutMs = 5000;
+constexpr char kSdpContentType[] = "application/sdp";
+constexpr char kTrickleContentType[] = "application/trickle-ice-sdpfrag";
+
+StrtcWhipSignal::StrtcWhipSignal(HttpRequestLoop* http_loop)
+    : http_loop_(http_loop), session_(std::make_shared<Session>()) {
+  RTC_LOG(LS_INFO) << __FUNCTION__;
+}
+
+StrtcWhipSignal::~StrtcWhipSignal() {
+  RTC_LOG(LS_INFO) << __FUNCTION__;
+  close();
+}
+
+void StrtcWhipSignal::postAsync(const std::string& url,
+                                const std::string& offer, ChannelType type,
+                                SignalCallback callback) {
+  std::string http_url = toHttpUrl(url);
+  std::unique_ptr<HttpClient> http_client(new HttpClient(
+      http_url, kDefaultSignalTimeoutMs, kDefaultSignalConnTimeoutMs));
+  if (!http_client->GetHandle()) {
+    RTC_LOG(LS_ERROR) << __FUNCTION__ << " http client is nullptr";
+    if (callback) {
+      callback(-1, "");
+    }
+    return;
+  }
+
+  parseOffer(offer, session_.get());
+
+  http_client->AddHeader("Content-Type", kSdpContentType);
+  http_client->AddContent(true, "", offer);
+
+  std::shared_ptr<Session> session = session_;
+  HttpRequestLoop* http_loop = http_loop_;
+  perform(http_loop, std::move(http_client),
+          [session, http_loop, http_url, callback](int code,
+                                                   HttpClient* http_client) {
+            onOfferResponse(session, http_loop, http_url, code, http_client,
+                            callback);
+          });
+}
+
+void StrtcWhipSignal::addCandidate(const std::string& mid, int mline_index,
+                                   const std::string& candidate) {
+  {
+    std::lock_guard<std::mutex> lock(session_->mutex);
+    if (session_->closed) {
+      return;
+    }
+    session_->pending_candidates.emplace_back(mid, candidate);
+  }
+  sendCandidates(session_, http_loop_);
+}
+
+void StrtcWhipSignal::endOfCandidates() {
+  {
+    std::lock_guard<std::mutex> lock(session_->mutex);
+    if (session_->closed) {
+      return;
+    }
+    session_->end_of_candidates = true;
+  }
+  sendCandidates(session_, http_loop_);
+}
+
+void StrtcWhipSignal::close() {
+  {
+    std::lock_guard<std::mutex> lock(session_->mutex);
+    if (session_->closed) {
+      return;
+    }
+    session_->closed = true;
+    session_->pending_candidates.clear();
+  }
+  // Without a resource yet the DELETE is sent once the offer completes.
+  sendDelete(session_, http_loop_);
+}
+
+// "whip://host:port/path" -> "http://host:port/path"
+// "whips://host:port/path" -> "https://host:port/path"
+std::string StrtcWhipSignal::toHttpUrl(const std::string& url) {
+  size_t scheme_end = url.find("://");
+  if (scheme_end == std::string::npos) {
+    return url;
+  }
+  std::string scheme = url.substr(0, scheme_end);
+  bool secure = scheme == "whips" || scheme == "wheps";
+  return (secure ? "https" : "http") + url.substr(scheme_end);
+}
+
+std::string StrtcWhipSignal::resolveUrl(const std::string& base,
+                                        const std::string& location) {
+  if (location.empty() || absl::StartsWith(location, "http://") ||
+      absl::StartsWith(location, "https://")) {
+    return location;
+  }
+
+  size_t host_begin = base.find("://");
+  host_begin = host_begin == std::string::npos ? 0 : host_begin + 3;
+  size_t host_end = base.find('/', host_begin);
+  std::string origin = base.substr(0, host_end);
+  if (location[0] == '/') {
+    return origin + location;
+  }
+
+  // Relative to the directory of the endpoint.
+  size_t query = base.find('?');
+  std::string path = base.substr(0, query);
+  size_t dir_end = path.rfind('/');
+  if (dir_end == std::string::npos || dir_end < host_begin) {
+    return origin + "/" + location;
+  }
+  return path.substr(0, dir_end + 1) + location;
+}
+
+void StrtcWhipSignal::parseOffer(const std::string& offer, Session* session) {
+  std::lock_guard<std::mutex> lock(session->mutex);
+  std::vector<std::string> lines;
+  rtc::split(offer, '\n', &lines);
+  std::string media_line;
+  for (auto& line : lines) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (absl::StartsWith(line, "m=")) {
+      media_line = line;
+    } else if (absl::StartsWith(line, "a=mid:")) {
+      session->media_lines[line.substr(6)] = media_line;
+    } else if (absl::StartsWith(line, "a=ice-ufrag:") &&
+               session->ice_ufrag.empty()) {
+      session->ice_ufrag = line.substr(12);
+    } else if (absl::StartsWith(line, "a=ice-pwd:") &&
+               session->ice_pwd.empty()) {
+      session->ice_pwd = line.substr(10);
+    }
+  }
+}
+
+void StrtcWhipSignal::onOfferResponse(std::shared_ptr<Session> session,
+                                      HttpRequestLoop* http_loop,
+                                      const std::string& http_url, int code,
+                                      HttpClient* http_client,
+                                      SignalCallback callback) {
+  long status_code = http_client ? http_client->GetHttpStatusCode() : -1;
+  if (code != 0 || status_code != 201) {
+    RTC_LOG(LS_ERROR) << __FUNCTION__ << " request failed code:" << code
+                      << " status:" << status_code;
+    if (callback) {
+      callback(-1, "");
+    }
+    return;
+  }
+
+  bool closed = false;
+  {
+    std::lock_guard<std::mutex> lock(session->mutex);
+    session->resource_url =
+        resolveUrl(http_url, http_client->GetHeader("Location"));
+    session->etag = http_client->GetHeader("ETag");
+    closed = session->closed;
+  }
+  RTC_LOG(LS_INFO) << __FUNCTION__ << " resource: " << session->resource_url;
+
+  if (callback) {
+    callback(0, http_client->GetContent());
+  }
+
+  if (closed) {
+    // close() was called while the offer was in flight.
+    sendDelete(session, http_loop);
+    return;
+  }
+  sendCandidates(session, http_loop);
+}
+
+void StrtcWhipSignal::sendCandidates(std::shared_ptr<Session> session,
+                                     HttpRequestLoop* http_loop) {
+  std::string resource_url;
+  std::string etag;
+  std::string fragment;
+  {
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (session->closed || session->resource_url.empty() ||
+        session->patch_in_flight ||
+        (session->pending_candidates.empty() && !session->end_of_candidates)) {
+      return;
+    }
+    session->patch_in_flight = true;
+    resource_url = session->resource_url;
+    etag = session->etag;
+
+    // RFC 8840 sdpfrag: ice credentials, then the candidates grouped under
+    // the m= line of their mid.
+    fragment = "a=ice-ufrag:" + session->ice_ufrag + "\r\n";
+    fragment += "a=ice-pwd:" + session->ice_pwd + "\r\n";
+    std::map<std::string, std::vector<std::string>> candidates;
+    for (const auto& candidate : session->pending_candidates) {
+      candidates[candidate.first].push_back(candidate.second);
+    }
+    for (const auto& it : candidates) {
+      fragment += session->media_lines[it.first] + "\r\n";
+      fragment += "a=mid:" + it.first + "\r\n";
+      for (const auto& candidate : it.second) {
+        fragment += "a=" + candidate + "\r\n";
+      }
+    }
+    if (session->end_of_candidates) {
+      fragment += "a=end-of-candidates\r\n";
+      session->end_of_candidates = false;
+    }
+    session->pending_candidates.clear();
+  }
+
+  std::unique_ptr<HttpClient> http_client(new HttpClient(
+      resource_url, kDefaultSignalTimeoutMs, kDefaultSignalConnTimeoutMs));
+  http_client->SetMethod("PATCH");
+  http_client->AddHeader("Content-Type", kTrickleContentType);
+  if (!etag.empty()) {
+    http_client->AddHeader("If-Match", etag);
+  }
+  http_client->AddContent(true, "", fragment);
+  perform(http_loop, std::move(http_client),
+          [session, http_loop](int code, HttpClient* http_client) {
+            long status_code =
+                http_client ? http_client->GetHttpStatusCode() : -1;
+            if (code != 0 || status_code / 100 != 2) {
+              RTC_LOG(LS_WARNING) << "whip trickle failed code:" << code
+                                  << " status:" << status_code;
+            }
+            {
+              std::lock_guard<std::mutex> lock(session->mutex);
+              session->patch_in_flight = false;
+            }
+            // Flush whatever was batched while this PATCH was in flight.
+            sendCandidates(session, http_loop);
+          });
+}
+
+void StrtcWhipSignal::sendDelete(std::shared_ptr<Session> session,
+                                 HttpRequestLoop* http_loop) {
+  std::string resource_url;
+  {
+    std::lock_guard<std::mutex> lock(session->mutex);
+    resource_url = session->resource_url;
+  }
+  if (resource_url.empty()) {
+    return;
+  }
+
+  std::unique_ptr<HttpClient> http_client(new HttpClient(
+      resource_url, kDefaultSignalTimeoutMs, kDefaultSignalConnTimeoutMs));
+  http_client->SetMethod("DELETE");
+  http_client->AddContent(false, "", "");
+  perform(http_loop, std::move(http_client),
+          [resource_url](int code, HttpClient* http_client) {
+            RTC_LOG(LS_INFO) << "whip delete " << resource_url
+                             << " code:" << code << " status:"
+                             << http_client->GetHttpStatusCode();
+          });
+}
+
+void StrtcWhipSignal::perform(HttpRequestLoop* http_loop,
+                              std::unique_ptr<HttpClient> http_client,
+                              HttpRequestLoop::Callback callback) {
+  if (http_loop) {
+    http_loop->Perform(std::move(http_client), std::move(callback));
+    return;
+  }
+  int code = http_client->DoEasy();
+  if (callback) {
+    callback(code, http_client.get());
+  }
+}
+}  // namespace strtc
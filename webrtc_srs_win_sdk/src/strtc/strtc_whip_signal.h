@@ -0,0 +1,71 @@
+#ifndef STRTC_WHIP_SIGNAL_H_
+#define STRTC_WHIP_SIGNAL_H_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "strtc_http_client.h"
+#include "strtc_signal.h"
+
+namespace strtc {
+// WHIP (publish) / WHEP (subscribe) signaling.
+// The offer is POSTed as soon as it is created, local candidates are sent
+// afterwards with PATCH (trickle ice) and the session resource is DELETEd on
+// close().
+// url: "whip://172.16.28.35:1985/rtc/v1/whip/?app=live&stream=livestream"
+class StrtcWhipSignal : public StrtcSignal {
+ public:
+  explicit StrtcWhipSignal(HttpRequestLoop* http_loop = nullptr);
+  ~StrtcWhipSignal() override;
+
+  void postAsync(const std::string& url, const std::string& offer,
+                 ChannelType type, SignalCallback callback) override;
+  void addCandidate(const std::string& mid, int mline_index,
+                    const std::string& candidate) override;
+  void endOfCandidates() override;
+  void close() override;
+
+ private:
+  // Shared with in-flight requests, which may finish after the signal is
+  // destroyed.
+  struct Session {
+    std::mutex mutex;
+    std::string resource_url;
+    std::string etag;
+    std::string ice_ufrag;
+    std::string ice_pwd;
+    // mid -> "m=" line of the offer.
+    std::map<std::string, std::string> media_lines;
+    std::vector<std::pair<std::string, std::string>> pending_candidates;
+    bool end_of_candidates = false;
+    // One trickle PATCH at a time, candidates gathered meanwhile are batched
+    // into the next one so end-of-candidates can never overtake them.
+    bool patch_in_flight = false;
+    bool closed = false;
+  };
+
+  static std::string toHttpUrl(const std::string& url);
+  static std::string resolveUrl(const std::string& base,
+                                const std::string& location);
+  static void parseOffer(const std::string& offer, Session* session);
+  static void onOfferResponse(std::shared_ptr<Session> session,
+                              HttpRequestLoop* http_loop,
+                              const std::string& http_url, int code,
+                              HttpClient* http_client,
+                              SignalCallback callback);
+  static void sendCandidates(std::shared_ptr<Session> session,
+                             HttpRequestLoop* http_loop);
+  static void sendDelete(std::shared_ptr<Session> session,
+                         HttpRequestLoop* http_loop);
+  static void perform(HttpRequestLoop* http_loop,
+                      std::unique_ptr<HttpClient> http_client,
+                      HttpRequestLoop::Callback callback);
+
+ private:
+  HttpRequestLoop* http_loop_;
+  std::shared_ptr<Session> session_;
+};
+}  // namespace strtc
+#endif  // STRTC_WHIP_SIGNAL_H_
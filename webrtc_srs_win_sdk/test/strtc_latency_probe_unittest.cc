@@ -0,0 +1,242 @@
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "api/frame_transformer_interface.h"
+#include "api/rtp_parameters.h"
+#include "api/video/i420_buffer.h"
+#include "api/video/video_frame.h"
+#include "api/video/video_frame_metadata.h"
+#include "common_video/h264/h264_common.h"
+#include "modules/rtp_rtcp/source/rtp_video_header.h"
+#include "rtc_base/time_utils.h"
+#include "strtc_latency_probe.h"
+#include "strtc_test.h"
+
+namespace {
+constexpr uint8_t kVp8PayloadType = 96;
+constexpr uint8_t kVp9PayloadType = 98;
+constexpr uint8_t kH264PayloadType = 102;
+constexpr uint32_t kSsrc = 1234;
+// The sender's constant between 90 * capture ms and the RTP timestamp.
+constexpr uint32_t kRtpOffset = 3000000;
+
+// Both payloads end in two zero bytes, so a stamp starting with 01 would
+// complete a start code.
+const std::vector<uint8_t> kVp8Frame = {0x10, 0x02, 0x00, 0x9d,
+                                        0x01, 0x2a, 0x00, 0x00};
+// SPS, PPS, IDR slice.
+const std::vector<uint8_t> kH264Frame = {
+    0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0x00, 0x1f, 0x00, 0x00, 0x00, 0x01,
+    0x68, 0xce, 0x3c, 0x80, 0x00, 0x00, 0x01, 0x65, 0x88, 0x84, 0x00, 0x00};
+
+class FakeFrame : public webrtc::TransformableVideoFrameInterface {
+ public:
+  FakeFrame(uint8_t payload_type, uint32_t rtp, std::vector<uint8_t> data)
+      : payload_type_(payload_type),
+        rtp_(rtp),
+        data_(std::move(data)),
+        metadata_(webrtc::RTPVideoHeader()) {}
+
+  rtc::ArrayView<const uint8_t> GetData() const override { return data_; }
+  void SetData(rtc::ArrayView<const uint8_t> data) override {
+    data_.assign(data.begin(), data.end());
+  }
+  uint8_t GetPayloadType() const override { return payload_type_; }
+  uint32_t GetSsrc() const override { return kSsrc; }
+  uint32_t GetTimestamp() const override { return rtp_; }
+  bool IsKeyFrame() const override { return true; }
+  std::vector<uint8_t> GetAdditionalData() const override { return {}; }
+  const webrtc::VideoFrameMetadata& GetMetadata() const override {
+    return metadata_;
+  }
+
+ private:
+  const uint8_t payload_type_;
+  const uint32_t rtp_;
+  std::vector<uint8_t> data_;
+  webrtc::VideoFrameMetadata metadata_;
+};
+
+// Keeps the payload of the last frame a transformer handed on.
+class FrameCollector : public webrtc::TransformedFrameCallback {
+ public:
+  void OnTransformedFrame(
+      std::unique_ptr<webrtc::TransformableFrameInterface> frame) override {
+    rtc::ArrayView<const uint8_t> data = frame->GetData();
+    last_.assign(data.begin(), data.end());
+  }
+
+  const std::vector<uint8_t>& last() const { return last_; }
+
+ private:
+  std::vector<uint8_t> last_;
+};
+
+std::vector<webrtc::RtpCodecParameters> Codecs() {
+  std::vector<webrtc::RtpCodecParameters> codecs(3);
+  codecs[0].name = "VP8";
+  codecs[0].payload_type = kVp8PayloadType;
+  codecs[1].name = "VP9";
+  codecs[1].payload_type = kVp9PayloadType;
+  codecs[2].name = "H264";
+  codecs[2].payload_type = kH264PayloadType;
+  return codecs;
+}
+
+webrtc::VideoFrame Frame(int64_t timestamp_us, uint32_t rtp) {
+  return webrtc::VideoFrame::Builder()
+      .set_video_frame_buffer(webrtc::I420Buffer::Create(2, 2))
+      .set_timestamp_us(timestamp_us)
+      .set_timestamp_rtp(rtp)
+      .build();
+}
+
+bool HasStartCode(const std::vector<uint8_t>& data, size_t from) {
+  for (size_t i = from; i + 2 < data.size(); ++i) {
+    if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Publisher and subscriber half, wired back to back like SRS would.
+class Loopback {
+ public:
+  Loopback()
+      : stamper_(rtc::make_ref_counted<strtc::LatencyStamper>()),
+        reader_(rtc::make_ref_counted<strtc::LatencyReader>(
+            0,
+            [this](const strtc::LatencySummary& summary) {
+              reports_.push_back(summary);
+            })),
+        sent_(rtc::make_ref_counted<FrameCollector>()),
+        decoded_(rtc::make_ref_counted<FrameCollector>()) {
+    stamper_->RegisterTransformedFrameCallback(sent_);
+    reader_->RegisterTransformedFrameCallback(decoded_);
+    stamper_->SetCodecs(Codecs());
+    reader_->SetCodecs(Codecs());
+  }
+
+  ~Loopback() { reader_->Stop(); }
+
+  // Captures, encodes to `payload`, sends and decodes one frame. Returns
+  // its RTP timestamp.
+  uint32_t Send(uint8_t payload_type, const std::vector<uint8_t>& payload) {
+    int64_t timestamp_us = rtc::TimeMicros();
+    uint32_t rtp = static_cast<uint32_t>(timestamp_us /
+                                         rtc::kNumMicrosecsPerMillisec) *
+                       90u +
+                   kRtpOffset;
+    stamper_->OnFrame(Frame(timestamp_us, rtp));
+    stamper_->Transform(
+        std::make_unique<FakeFrame>(payload_type, rtp, payload));
+    reader_->Transform(
+        std::make_unique<FakeFrame>(payload_type, rtp, sent_->last()));
+    return rtp;
+  }
+
+  void Render(uint32_t rtp) { reader_->OnFrame(Frame(0, rtp)); }
+
+  const std::vector<uint8_t>& sent() const { return sent_->last(); }
+  const std::vector<uint8_t>& decoded() const { return decoded_->last(); }
+  const std::vector<strtc::LatencySummary>& reports() const {
+    return reports_;
+  }
+
+ private:
+  std::vector<strtc::LatencySummary> reports_;
+  rtc::scoped_refptr<strtc::LatencyStamper> stamper_;
+  rtc::scoped_refptr<strtc::LatencyReader> reader_;
+  rtc::scoped_refptr<FrameCollector> sent_;
+  rtc::scoped_refptr<FrameCollector> decoded_;
+};
+}  // namespace
+
+STRTC_TEST(Vp8TrailerRoundTrips) {
+  Loopback loopback;
+  uint32_t rtp = loopback.Send(kVp8PayloadType, kVp8Frame);
+  STRTC_EXPECT(loopback.sent().size() > kVp8Frame.size());
+  STRTC_EXPECT(std::equal(kVp8Frame.begin(), kVp8Frame.end(),
+                          loopback.sent().begin()));
+  STRTC_EXPECT(loopback.decoded() == kVp8Frame);
+
+  loopback.Render(rtp);
+  STRTC_EXPECT(loopback.reports().size() == 1);
+  if (!loopback.reports().empty()) {
+    STRTC_EXPECT(loopback.reports()[0].count == 1);
+    STRTC_EXPECT(loopback.reports()[0].maxMs < 1000);
+  }
+}
+
+STRTC_TEST(Vp8TrailerNeverFormsStartCode) {
+  Loopback loopback;
+  loopback.Send(kVp8PayloadType, kVp8Frame);
+  // From the last two payload bytes on, across the join.
+  STRTC_EXPECT(!HasStartCode(loopback.sent(), kVp8Frame.size() - 2));
+}
+
+STRTC_TEST(H264StampIsSeiBeforeFirstSlice) {
+  Loopback loopback;
+  loopback.Send(kH264PayloadType, kH264Frame);
+  const std::vector<uint8_t>& sent = loopback.sent();
+  std::vector<webrtc::H264::NaluIndex> nalus =
+      webrtc::H264::FindNaluIndices(sent.data(), sent.size());
+  STRTC_EXPECT(nalus.size() == 4);
+  if (nalus.size() == 4) {
+    STRTC_EXPECT(sent[nalus[2].payload_start_offset] == webrtc::H264::kSei);
+    STRTC_EXPECT((sent[nalus[3].payload_start_offset] & 0x1f) ==
+                 webrtc::H264::kIdr);
+  }
+  for (const auto& nalu : nalus) {
+    // forbidden_zero_bit
+    STRTC_EXPECT((sent[nalu.payload_start_offset] & 0x80) == 0);
+  }
+}
+
+STRTC_TEST(H264SeiRoundTrips) {
+  Loopback loopback;
+  uint32_t rtp = loopback.Send(kH264PayloadType, kH264Frame);
+  STRTC_EXPECT(loopback.decoded() == kH264Frame);
+  loopback.Render(rtp);
+  STRTC_EXPECT(loopback.reports().size() == 1);
+}
+
+STRTC_TEST(OtherCodecsPassThrough) {
+  Loopback loopback;
+  uint32_t rtp = loopback.Send(kVp9PayloadType, kVp8Frame);
+  STRTC_EXPECT(loopback.sent() == kVp8Frame);
+  STRTC_EXPECT(loopback.decoded() == kVp8Frame);
+  loopback.Render(rtp);
+  STRTC_EXPECT(loopback.reports().empty());
+
+  loopback.Send(127, kH264Frame);
+  STRTC_EXPECT(loopback.sent() == kH264Frame);
+}
+
+STRTC_TEST(UnstampedFramesReachDecoderUnchanged) {
+  auto reader = rtc::make_ref_counted<strtc::LatencyReader>(
+      0, [](const strtc::LatencySummary&) {});
+  auto decoded = rtc::make_ref_counted<FrameCollector>();
+  reader->RegisterTransformedFrameCallback(decoded);
+  reader->SetCodecs(Codecs());
+  reader->Transform(
+      std::make_unique<FakeFrame>(kH264PayloadType, 0, kH264Frame));
+  STRTC_EXPECT(decoded->last() == kH264Frame);
+  reader->Transform(std::make_unique<FakeFrame>(kVp8PayloadType, 0, kVp8Frame));
+  STRTC_EXPECT(decoded->last() == kVp8Frame);
+}
+
+STRTC_TEST(NothingStampedBeforeCodecsAreKnown) {
+  auto stamper = rtc::make_ref_counted<strtc::LatencyStamper>();
+  auto sent = rtc::make_ref_counted<FrameCollector>();
+  stamper->RegisterTransformedFrameCallback(sent);
+  stamper->Transform(
+      std::make_unique<FakeFrame>(kH264PayloadType, 0, kH264Frame));
+  STRTC_EXPECT(sent->last() == kH264Frame);
+}
+
+int main() {
+  return strtc::test::RunAll();
+}
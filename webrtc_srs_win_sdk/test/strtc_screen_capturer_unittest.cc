@@ -0,0 +1,227 @@
+#include <string.h>
+
+#include <memory>
+#include <mutex>
+
+#include "api/video/video_frame.h"
+#include "api/video/video_sink_interface.h"
+#include "modules/desktop_capture/desktop_capturer.h"
+#include "modules/desktop_capture/desktop_frame.h"
+#include "modules/desktop_capture/desktop_region.h"
+#include "strtc_screen_capturer.h"
+#include "strtc_test.h"
+
+namespace {
+constexpr int kFps = 100;
+constexpr int kTimeoutMs = 2000;
+// BT.601 limited range luma of the two colors painted below.
+constexpr int kWhiteY = 235;
+constexpr int kBlackY = 16;
+
+// A desktop the test paints on. Every capture returns its current content,
+// with the area painted since the previous capture as the updated region.
+class FakeDesktopCapturer : public webrtc::DesktopCapturer {
+ public:
+  explicit FakeDesktopCapturer(webrtc::DesktopSize size) { Resize(size); }
+
+  void Start(Callback* callback) override { callback_ = callback; }
+
+  void CaptureFrame() override {
+    std::unique_ptr<webrtc::DesktopFrame> frame;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      frame.reset(new webrtc::BasicDesktopFrame(content_->size()));
+      frame->CopyPixelsFrom(*content_, webrtc::DesktopVector(),
+                            webrtc::DesktopRect::MakeSize(content_->size()));
+      frame->mutable_updated_region()->Swap(&painted_);
+      painted_.Clear();
+      ++captures_;
+    }
+    callback_->OnCaptureResult(Result::SUCCESS, std::move(frame));
+  }
+
+  bool GetSourceList(SourceList* sources) override {
+    sources->push_back({0, "fake"});
+    return true;
+  }
+  bool SelectSource(SourceId id) override { return id == 0; }
+
+  // Starts over with an all white desktop of `size`, like a resized window.
+  void Resize(webrtc::DesktopSize size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    content_.reset(new webrtc::BasicDesktopFrame(size));
+    memset(content_->data(), 0xff, content_->stride() * size.height());
+    painted_.SetRect(webrtc::DesktopRect::MakeSize(size));
+  }
+
+  void PaintBlack(const webrtc::DesktopRect& rect) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int y = rect.top(); y < rect.bottom(); ++y) {
+      uint8_t* row =
+          content_->GetFrameDataAtPos(webrtc::DesktopVector(rect.left(), y));
+      for (int x = 0; x < rect.width(); ++x) {
+        row[x * 4 + 0] = 0;
+        row[x * 4 + 1] = 0;
+        row[x * 4 + 2] = 0;
+      }
+    }
+    painted_.AddRect(rect);
+  }
+
+  int captures() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return captures_;
+  }
+
+ private:
+  Callback* callback_ = nullptr;
+  std::mutex mutex_;
+  std::unique_ptr<webrtc::DesktopFrame> content_;
+  webrtc::DesktopRegion painted_;
+  int captures_ = 0;
+};
+
+// Keeps only the latest frame, so the capturer's buffer pool never runs dry.
+class LastFrameSink : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
+ public:
+  void OnFrame(const webrtc::VideoFrame& frame) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frame_ = frame;
+    ++frames_;
+  }
+
+  int frames() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return frames_;
+  }
+
+  webrtc::VideoFrame frame() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return *frame_;
+  }
+
+ private:
+  std::mutex mutex_;
+  absl::optional<webrtc::VideoFrame> frame_;
+  int frames_ = 0;
+};
+
+int LumaAt(const webrtc::VideoFrame& frame, int x, int y) {
+  rtc::scoped_refptr<webrtc::I420BufferInterface> i420 =
+      frame.video_frame_buffer()->ToI420();
+  return i420->DataY()[y * i420->StrideY() + x];
+}
+
+bool Near(int value, int expected) {
+  return value >= expected - 4 && value <= expected + 4;
+}
+
+struct Fixture {
+  explicit Fixture(webrtc::DesktopSize size)
+      : desktop(new FakeDesktopCapturer(size)) {
+    capturer = strtc::ScreenCapturer::Create(
+        kFps, std::unique_ptr<webrtc::DesktopCapturer>(desktop));
+    capturer->AddOrUpdateSink(&sink, rtc::VideoSinkWants());
+  }
+  ~Fixture() {
+    capturer->RemoveSink(&sink);
+    capturer.reset();
+  }
+
+  // Waits until a frame after the current one arrived.
+  bool WaitNextFrame() {
+    int frames = sink.frames();
+    return strtc::test::WaitFor([&]() { return sink.frames() > frames; },
+                                kTimeoutMs);
+  }
+
+  // Owned by `capturer`.
+  FakeDesktopCapturer* desktop;
+  LastFrameSink sink;
+  std::unique_ptr<strtc::ScreenCapturer> capturer;
+};
+}  // namespace
+
+STRTC_TEST(DeliversFirstCaptureInFull) {
+  Fixture fixture(webrtc::DesktopSize(64, 48));
+  STRTC_EXPECT(strtc::test::WaitFor(
+      [&]() { return fixture.sink.frames() > 0; }, kTimeoutMs));
+
+  webrtc::VideoFrame frame = fixture.sink.frame();
+  STRTC_EXPECT(frame.width() == 64);
+  STRTC_EXPECT(frame.height() == 48);
+  STRTC_EXPECT(Near(LumaAt(frame, 0, 0), kWhiteY));
+  STRTC_EXPECT(Near(LumaAt(frame, 63, 47), kWhiteY));
+  STRTC_EXPECT(fixture.capturer->GetStats().converted_pixels == 64 * 48);
+}
+
+STRTC_TEST(SkipsUnchangedCaptures) {
+  Fixture fixture(webrtc::DesktopSize(64, 48));
+  STRTC_EXPECT(strtc::test::WaitFor(
+      [&]() { return fixture.sink.frames() > 0; }, kTimeoutMs));
+  // Nothing painted, none of these captures may produce a frame.
+  int captures = fixture.desktop->captures();
+  STRTC_EXPECT(strtc::test::WaitFor(
+      [&]() { return fixture.desktop->captures() >= captures + 10; },
+      kTimeoutMs));
+
+  strtc::ScreenCapturer::Stats stats = fixture.capturer->GetStats();
+  STRTC_EXPECT(fixture.sink.frames() == 1);
+  STRTC_EXPECT(stats.delivered == 1);
+  STRTC_EXPECT(stats.unchanged >= 10);
+}
+
+STRTC_TEST(ConvertsOnlyTheDamage) {
+  const int width = 320;
+  const int height = 240;
+  Fixture fixture(webrtc::DesktopSize(width, height));
+  STRTC_EXPECT(strtc::test::WaitFor(
+      [&]() { return fixture.sink.frames() > 0; }, kTimeoutMs));
+
+  // Walk a 16 x 16 black square across the desktop. Each buffer of the pool
+  // is converted in full once, after that only the squares painted since it
+  // was last written.
+  const int squares = 12;
+  for (int i = 0; i < squares; ++i) {
+    webrtc::DesktopRect square =
+        webrtc::DesktopRect::MakeXYWH(i * 20, 100, 16, 16);
+    fixture.desktop->PaintBlack(square);
+    STRTC_EXPECT(fixture.WaitNextFrame());
+
+    webrtc::VideoFrame frame = fixture.sink.frame();
+    STRTC_EXPECT(frame.has_update_rect());
+    STRTC_EXPECT(frame.update_rect().offset_x == square.left());
+    STRTC_EXPECT(frame.update_rect().offset_y == square.top());
+    STRTC_EXPECT(frame.update_rect().width == 16);
+    STRTC_EXPECT(frame.update_rect().height == 16);
+    // Every square painted so far shows, whichever pooled buffer was used.
+    for (int j = 0; j <= i; ++j) {
+      STRTC_EXPECT(Near(LumaAt(frame, j * 20 + 8, 108), kBlackY));
+    }
+    STRTC_EXPECT(Near(LumaAt(frame, i * 20 + 8, 50), kWhiteY));
+  }
+
+  strtc::ScreenCapturer::Stats stats = fixture.capturer->GetStats();
+  STRTC_EXPECT(stats.delivered == squares + 1);
+  // At most three full conversions, the rest is damage.
+  STRTC_EXPECT(stats.converted_pixels <=
+               3 * width * height + squares * 3 * 16 * 16);
+  STRTC_EXPECT(stats.converted_pixels < (squares + 1) * width * height / 2);
+}
+
+STRTC_TEST(FollowsSourceResize) {
+  Fixture fixture(webrtc::DesktopSize(64, 48));
+  STRTC_EXPECT(strtc::test::WaitFor(
+      [&]() { return fixture.sink.frames() > 0; }, kTimeoutMs));
+
+  fixture.desktop->Resize(webrtc::DesktopSize(96, 64));
+  STRTC_EXPECT(strtc::test::WaitFor(
+      [&]() { return fixture.sink.frame().width() == 96; }, kTimeoutMs));
+  webrtc::VideoFrame frame = fixture.sink.frame();
+  STRTC_EXPECT(frame.height() == 64);
+  STRTC_EXPECT(Near(LumaAt(frame, 95, 63), kWhiteY));
+}
+
+int main() {
+  return strtc::test::RunAll();
+}
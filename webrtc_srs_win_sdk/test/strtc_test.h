@@ -0,0 +1,75 @@
+#ifndef STRTC_TEST_H_
+#define STRTC_TEST_H_
+
+#include <stdio.h>
+
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// Minimal test registry for the Linux test executables. Each executable
+// defines its cases with STRTC_TEST and returns strtc::test::RunAll() from
+// main(), a non-zero exit code means at least one failed expectation.
+namespace strtc {
+namespace test {
+struct TestCase {
+  const char* name;
+  void (*function)();
+};
+
+inline std::vector<TestCase>& Registry() {
+  static std::vector<TestCase> registry;
+  return registry;
+}
+
+inline int& Failures() {
+  static int failures = 0;
+  return failures;
+}
+
+struct Registrar {
+  Registrar(const char* name, void (*function)()) {
+    Registry().push_back({name, function});
+  }
+};
+
+inline int RunAll() {
+  for (const TestCase& test : Registry()) {
+    int failures = Failures();
+    printf("[ RUN  ] %s\n", test.name);
+    test.function();
+    printf("[ %s ] %s\n", Failures() == failures ? " OK " : "FAIL", test.name);
+  }
+  return Failures() == 0 ? 0 : 1;
+}
+
+// Polls `condition` until it holds or `timeout_ms` passed.
+inline bool WaitFor(std::function<bool()> condition, int timeout_ms) {
+  auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (!condition()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  return true;
+}
+}  // namespace test
+}  // namespace strtc
+
+#define STRTC_TEST(name)                                                      \
+  static void name();                                                         \
+  static strtc::test::Registrar name##_registrar(#name, name);                \
+  static void name()
+
+#define STRTC_EXPECT(condition)                                               \
+  do {                                                                        \
+    if (!(condition)) {                                                       \
+      printf("%s:%d: expected %s\n", __FILE__, __LINE__, #condition);         \
+      ++strtc::test::Failures();                                              \
+    }                                                                         \
+  } while (0)
+
+#endif  // STRTC_TEST_H_
@@ -0,0 +1,78 @@
+#include <string>
+#include <vector>
+
+#include "modules/video_capture/video_capture_defines.h"
+#include "strtc_test.h"
+#include "strtc_vcm_capturer.h"
+
+namespace {
+webrtc::VideoCaptureCapability Mode(webrtc::VideoType type, int width,
+                                    int height, int fps) {
+  webrtc::VideoCaptureCapability capability;
+  capability.videoType = type;
+  capability.width = width;
+  capability.height = height;
+  capability.maxFPS = fps;
+  return capability;
+}
+}  // namespace
+
+STRTC_TEST(ExactRepackBeatsLargeCopy) {
+  std::vector<webrtc::VideoCaptureCapability> modes = {
+      Mode(webrtc::VideoType::kI420, 1920, 1080, 30),
+      Mode(webrtc::VideoType::kYUY2, 640, 480, 30)};
+  strtc::CaptureFormat format;
+  STRTC_EXPECT(strtc::VcmCapturer::SelectCaptureFormat(modes, 640, 480, 30,
+                                                       &format));
+  STRTC_EXPECT(format.capability.videoType == webrtc::VideoType::kYUY2);
+  STRTC_EXPECT(!format.scaled);
+  STRTC_EXPECT(!format.degraded);
+  STRTC_EXPECT(format.video_type == "YUY2");
+  STRTC_EXPECT(std::string(format.conversion()) == "repack");
+}
+
+STRTC_TEST(SmallerCopyBeatsExactDecode) {
+  std::vector<webrtc::VideoCaptureCapability> modes = {
+      Mode(webrtc::VideoType::kMJPEG, 640, 480, 30),
+      Mode(webrtc::VideoType::kI420, 800, 600, 30)};
+  strtc::CaptureFormat format;
+  STRTC_EXPECT(strtc::VcmCapturer::SelectCaptureFormat(modes, 640, 480, 30,
+                                                       &format));
+  STRTC_EXPECT(format.capability.videoType == webrtc::VideoType::kI420);
+  STRTC_EXPECT(format.scaled);
+}
+
+STRTC_TEST(ModesThatFallShortLoseFirst) {
+  std::vector<webrtc::VideoCaptureCapability> modes = {
+      Mode(webrtc::VideoType::kI420, 320, 240, 30),
+      Mode(webrtc::VideoType::kI420, 1280, 720, 15),
+      Mode(webrtc::VideoType::kMJPEG, 1280, 720, 30)};
+  strtc::CaptureFormat format;
+  STRTC_EXPECT(strtc::VcmCapturer::SelectCaptureFormat(modes, 1280, 720, 30,
+                                                       &format));
+  STRTC_EXPECT(format.capability.videoType == webrtc::VideoType::kMJPEG);
+  STRTC_EXPECT(!format.degraded);
+  STRTC_EXPECT(format.path == "MJPEG 1280x720@30 -> I420 (decode)");
+}
+
+STRTC_TEST(FasterModeCostsMore) {
+  std::vector<webrtc::VideoCaptureCapability> modes = {
+      Mode(webrtc::VideoType::kYUY2, 640, 480, 60),
+      Mode(webrtc::VideoType::kYUY2, 640, 480, 30)};
+  strtc::CaptureFormat format;
+  STRTC_EXPECT(strtc::VcmCapturer::SelectCaptureFormat(modes, 640, 480, 25,
+                                                       &format));
+  STRTC_EXPECT(format.capability.maxFPS == 30);
+}
+
+STRTC_TEST(NoUsableMode) {
+  std::vector<webrtc::VideoCaptureCapability> modes = {
+      Mode(webrtc::VideoType::kUnknown, 640, 480, 30)};
+  strtc::CaptureFormat format;
+  STRTC_EXPECT(!strtc::VcmCapturer::SelectCaptureFormat(modes, 640, 480, 30,
+                                                        &format));
+}
+
+int main() {
+  return strtc::test::RunAll();
+}
@@ -0,0 +1,219 @@
+#include <string.h>
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "api/video/i420_buffer.h"
+#include "api/video/video_frame.h"
+#include "strtc_test.h"
+#include "strtc_video_compositor.h"
+#include "strtc_video_render_surface.h"
+
+namespace {
+constexpr int kCanvasWidth = 320;
+constexpr int kCanvasHeight = 180;
+constexpr int kTimeoutMs = 2000;
+
+// BT.601 limited range red.
+webrtc::VideoFrame RedFrame(int width, int height) {
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      webrtc::I420Buffer::Create(width, height);
+  memset(buffer->MutableDataY(), 81, buffer->StrideY() * height);
+  memset(buffer->MutableDataU(), 90,
+         buffer->StrideU() * buffer->ChromaHeight());
+  memset(buffer->MutableDataV(), 240,
+         buffer->StrideV() * buffer->ChromaHeight());
+  return webrtc::VideoFrame::Builder().set_video_frame_buffer(buffer).build();
+}
+
+struct Image {
+  std::vector<uint8_t> argb;
+  int width = 0;
+  int height = 0;
+
+  // libyuv ARGB is B, G, R, A in memory.
+  bool IsRed(int x, int y) const {
+    const uint8_t* pixel = &argb[(y * width + x) * 4];
+    return pixel[2] > 200 && pixel[1] < 60 && pixel[0] < 60;
+  }
+  bool IsBlack(int x, int y) const {
+    const uint8_t* pixel = &argb[(y * width + x) * 4];
+    return pixel[2] < 20 && pixel[1] < 20 && pixel[0] < 20;
+  }
+};
+
+// Feeds frames to `sink` until the surface presented an image for which
+// `condition` holds.
+bool PresentUntil(strtc::MemoryRenderSurface* surface,
+                  rtc::VideoSinkInterface<webrtc::VideoFrame>* sink,
+                  const webrtc::VideoFrame& frame, Image* image,
+                  std::function<bool(const Image&)> condition) {
+  return strtc::test::WaitFor(
+      [&]() {
+        sink->OnFrame(frame);
+        return surface->GetImage(&image->argb, &image->width,
+                                 &image->height) &&
+               condition(*image);
+      },
+      kTimeoutMs);
+}
+
+// Blocks in Present() until released, like a display waiting for vsync.
+class BlockingSurface : public strtc::VideoRenderSurface {
+ public:
+  int RefreshIntervalMs() override { return 1; }
+
+  void Present(const uint8_t* argb, int stride, int width,
+               int height) override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    presenting_ = true;
+    cond_.notify_all();
+    cond_.wait(lock, [this]() { return released_; });
+  }
+
+  bool WaitPresenting(int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cond_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                          [this]() { return presenting_; });
+  }
+
+  void Release() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    released_ = true;
+    cond_.notify_all();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  bool presenting_ = false;
+  bool released_ = false;
+};
+}  // namespace
+
+STRTC_TEST(DrawsTileIntoItsRectangle) {
+  strtc::MemoryRenderSurface* surface = new strtc::MemoryRenderSurface(5);
+  strtc::VideoCompositor compositor(
+      std::unique_ptr<strtc::VideoRenderSurface>(surface), kCanvasWidth,
+      kCanvasHeight);
+  rtc::VideoSinkInterface<webrtc::VideoFrame>* sink =
+      compositor.AddTile(0, 0, 0, kCanvasWidth / 2, kCanvasHeight / 2, 0);
+
+  Image image;
+  STRTC_EXPECT(PresentUntil(surface, sink, RedFrame(640, 360), &image,
+                            [](const Image& image) {
+                              return image.IsRed(80, 45);
+                            }));
+  STRTC_EXPECT(image.width == kCanvasWidth);
+  STRTC_EXPECT(image.height == kCanvasHeight);
+  STRTC_EXPECT(image.IsBlack(kCanvasWidth - 1, kCanvasHeight - 1));
+  STRTC_EXPECT(image.IsBlack(kCanvasWidth / 2 + 10, 10));
+
+  std::vector<strtc::VideoTileStats> stats = compositor.GetStats();
+  STRTC_EXPECT(stats.size() == 1);
+  STRTC_EXPECT(!stats.empty() && stats[0].rendered > 0);
+}
+
+STRTC_TEST(RemovedTileIsCleared) {
+  strtc::MemoryRenderSurface* surface = new strtc::MemoryRenderSurface(5);
+  strtc::VideoCompositor compositor(
+      std::unique_ptr<strtc::VideoRenderSurface>(surface), kCanvasWidth,
+      kCanvasHeight);
+  rtc::VideoSinkInterface<webrtc::VideoFrame>* sink =
+      compositor.AddTile(0, 0, 0, kCanvasWidth, kCanvasHeight, 0);
+
+  Image image;
+  STRTC_EXPECT(PresentUntil(surface, sink, RedFrame(320, 180), &image,
+                            [](const Image& image) {
+                              return image.IsRed(160, 90);
+                            }));
+
+  compositor.RemoveTile(0);
+  STRTC_EXPECT(strtc::test::WaitFor(
+      [&]() {
+        return surface->GetImage(&image.argb, &image.width, &image.height) &&
+               image.IsBlack(160, 90);
+      },
+      kTimeoutMs));
+}
+
+STRTC_TEST(IdleWallIsNotPresentedAgain) {
+  strtc::MemoryRenderSurface* surface = new strtc::MemoryRenderSurface(5);
+  strtc::VideoCompositor compositor(
+      std::unique_ptr<strtc::VideoRenderSurface>(surface), kCanvasWidth,
+      kCanvasHeight);
+  // A tile whose channel is still connecting, and one without any area.
+  compositor.AddTile(0, 0, 0, kCanvasWidth / 2, kCanvasHeight, 0);
+  compositor.AddTile(1, kCanvasWidth, 0, 0, 0, 0);
+  STRTC_EXPECT(strtc::test::WaitFor(
+      [&]() { return surface->presented() > 0; }, kTimeoutMs));
+
+  // Settle, then twenty refresh intervals without a frame.
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  int64_t presented = surface->presented();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  STRTC_EXPECT(surface->presented() == presented);
+}
+
+STRTC_TEST(CanvasFollowsSurfaceResize) {
+  strtc::MemoryRenderSurface* surface = new strtc::MemoryRenderSurface(5);
+  strtc::VideoCompositor compositor(
+      std::unique_ptr<strtc::VideoRenderSurface>(surface), kCanvasWidth,
+      kCanvasHeight);
+  // Left half of a 2 x 1 wall.
+  rtc::VideoSinkInterface<webrtc::VideoFrame>* sink =
+      compositor.AddTile(0, 0, 0, kCanvasWidth / 2, kCanvasHeight, 0);
+  webrtc::VideoFrame frame = RedFrame(320, 360);
+
+  Image image;
+  STRTC_EXPECT(PresentUntil(surface, sink, frame, &image,
+                            [](const Image& image) {
+                              return image.IsRed(80, 90);
+                            }));
+
+  surface->SetTargetSize(640, 360);
+  STRTC_EXPECT(PresentUntil(surface, sink, frame, &image,
+                            [](const Image& image) {
+                              return image.width == 640 &&
+                                     image.height == 360 &&
+                                     image.IsRed(160, 180);
+                            }));
+  int width = 0;
+  int height = 0;
+  compositor.GetSize(&width, &height);
+  STRTC_EXPECT(width == 640);
+  STRTC_EXPECT(height == 360);
+  // The tile grew with the canvas and still covers exactly the left half.
+  STRTC_EXPECT(image.IsRed(300, 180));
+  STRTC_EXPECT(image.IsBlack(340, 180));
+}
+
+STRTC_TEST(PresentDoesNotBlockTileChanges) {
+  BlockingSurface* surface = new BlockingSurface();
+  strtc::VideoCompositor compositor(
+      std::unique_ptr<strtc::VideoRenderSurface>(surface), kCanvasWidth,
+      kCanvasHeight);
+  // The first tile dirties the canvas, the compositor then blocks presenting.
+  compositor.AddTile(0, 0, 0, kCanvasWidth / 2, kCanvasHeight, 0);
+  STRTC_EXPECT(surface->WaitPresenting(kTimeoutMs));
+
+  std::future<void> changed = std::async(std::launch::async, [&]() {
+    compositor.AddTile(1, kCanvasWidth / 2, 0, kCanvasWidth / 2,
+                       kCanvasHeight, 0);
+    compositor.RemoveTile(0);
+    compositor.GetStats();
+  });
+  STRTC_EXPECT(changed.wait_for(std::chrono::milliseconds(kTimeoutMs)) ==
+               std::future_status::ready);
+  surface->Release();
+  changed.wait();
+}
+
+int main() {
+  return strtc::test::RunAll();
+}
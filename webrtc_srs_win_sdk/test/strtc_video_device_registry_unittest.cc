@@ -0,0 +1,177 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "strtc_test.h"
+#include "strtc_video_device_registry.h"
+
+namespace {
+constexpr int kPollIntervalMs = 5;
+constexpr int kTimeoutMs = 2000;
+
+// Devices set by hand, counts the capability queries.
+class FakeVideoDeviceBackend : public strtc::VideoDeviceBackend {
+ public:
+  explicit FakeVideoDeviceBackend(std::vector<strtc::VideoDevice> devices)
+      : devices_(std::move(devices)) {}
+
+  // Seen by the registry at its next poll.
+  void SetDevices(std::vector<strtc::VideoDevice> devices) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    devices_ = std::move(devices);
+  }
+
+  int capability_queries() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return capability_queries_;
+  }
+
+  std::vector<strtc::VideoDevice> ListDevices() override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<strtc::VideoDevice> devices = devices_;
+    for (auto& device : devices) {
+      device.capabilities.clear();
+    }
+    return devices;
+  }
+
+  std::vector<webrtc::VideoCaptureCapability> GetCapabilities(
+      const std::string& id) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++capability_queries_;
+    for (const auto& device : devices_) {
+      if (device.id == id) {
+        return device.capabilities;
+      }
+    }
+    return {};
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<strtc::VideoDevice> devices_;
+  int capability_queries_ = 0;
+};
+
+strtc::VideoDevice Device(const std::string& id, int modes) {
+  strtc::VideoDevice device;
+  device.id = id;
+  device.name = "camera " + id;
+  for (int i = 0; i < modes; ++i) {
+    webrtc::VideoCaptureCapability capability;
+    capability.width = 640 * (i + 1);
+    capability.height = 360 * (i + 1);
+    capability.maxFPS = 30;
+    device.capabilities.push_back(capability);
+  }
+  return device;
+}
+
+// The registry owns its backend, the test keeps a pointer to drive it.
+struct Registry {
+  explicit Registry(std::vector<strtc::VideoDevice> devices)
+      : backend(new FakeVideoDeviceBackend(std::move(devices))),
+        registry(std::unique_ptr<strtc::VideoDeviceBackend>(backend),
+                 kPollIntervalMs) {
+    // The first enumeration notifies nobody, the tests change the devices
+    // after it.
+    registry.GetDevices();
+  }
+
+  bool WaitForDevices(size_t count) {
+    return strtc::test::WaitFor(
+        [&]() { return registry.GetDevices().size() == count; }, kTimeoutMs);
+  }
+
+  FakeVideoDeviceBackend* backend;
+  strtc::VideoDeviceRegistry registry;
+};
+}  // namespace
+
+STRTC_TEST(CapabilitiesQueriedOncePerNewDevice) {
+  Registry registry({Device("a", 2)});
+  std::vector<strtc::VideoDevice> devices = registry.registry.GetDevices();
+  STRTC_EXPECT(devices.size() == 1);
+  if (devices.size() == 1) {
+    STRTC_EXPECT(devices[0].capabilities.size() == 2);
+  }
+  STRTC_EXPECT(registry.backend->capability_queries() == 1);
+
+  // Unchanged polls are served from the cache.
+  std::this_thread::sleep_for(std::chrono::milliseconds(10 * kPollIntervalMs));
+  STRTC_EXPECT(registry.backend->capability_queries() == 1);
+
+  registry.backend->SetDevices({Device("a", 2), Device("b", 3)});
+  STRTC_EXPECT(registry.WaitForDevices(2));
+  STRTC_EXPECT(registry.backend->capability_queries() == 2);
+  strtc::VideoDevice device;
+  STRTC_EXPECT(registry.registry.GetDevice("a", &device));
+  STRTC_EXPECT(device.capabilities.size() == 2);
+  STRTC_EXPECT(registry.registry.GetDevice("b", &device));
+  STRTC_EXPECT(device.capabilities.size() == 3);
+}
+
+STRTC_TEST(PlugAndUnplugNotifyListeners) {
+  Registry registry({Device("a", 1)});
+  std::mutex mutex;
+  int calls = 0;
+  std::vector<strtc::VideoDevice> last;
+  int listener = registry.registry.AddListener(
+      [&](const std::vector<strtc::VideoDevice>& devices) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++calls;
+        last = devices;
+      });
+  auto notified = [&](int count, size_t devices) {
+    return strtc::test::WaitFor(
+        [&]() {
+          std::lock_guard<std::mutex> lock(mutex);
+          return calls == count && last.size() == devices;
+        },
+        kTimeoutMs);
+  };
+
+  registry.backend->SetDevices({Device("a", 1), Device("b", 1)});
+  STRTC_EXPECT(notified(1, 2));
+
+  registry.backend->SetDevices({Device("b", 1)});
+  STRTC_EXPECT(notified(2, 1));
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    STRTC_EXPECT(!last.empty() && last[0].id == "b");
+  }
+  registry.registry.RemoveListener(listener);
+}
+
+STRTC_TEST(NoCallbackAfterRemoveListener) {
+  Registry registry({Device("a", 1)});
+  std::atomic<bool> in_callback(false);
+  std::atomic<int> calls(0);
+  int listener = registry.registry.AddListener(
+      [&](const std::vector<strtc::VideoDevice>&) {
+        in_callback = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        ++calls;
+        in_callback = false;
+      });
+
+  registry.backend->SetDevices({Device("a", 1), Device("b", 1)});
+  STRTC_EXPECT(strtc::test::WaitFor([&]() { return in_callback.load(); },
+                                    kTimeoutMs));
+  // Waits for the running callback instead of returning under it.
+  registry.registry.RemoveListener(listener);
+  STRTC_EXPECT(!in_callback);
+  STRTC_EXPECT(calls == 1);
+
+  registry.backend->SetDevices({Device("b", 1)});
+  STRTC_EXPECT(registry.WaitForDevices(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(10 * kPollIntervalMs));
+  STRTC_EXPECT(calls == 1);
+}
+
+int main() {
+  return strtc::test::RunAll();
+}
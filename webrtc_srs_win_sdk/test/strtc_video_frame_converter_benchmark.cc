@@ -0,0 +1,144 @@
+// Compares the render conversion before and after VideoFrameConverter.
+//
+// legacy: the whole decoded frame is rotated and converted to ARGB, then
+// scaled to the tile (StretchDIBits with HALFTONE did this on Windows,
+// libyuv::ARGBScale stands in for it here).
+// fused:  VideoFrameConverter scales to the tile first, then rotates and
+// converts only the pixels that are shown.
+//
+// Prints the mean time per frame for every source size, tile size and
+// rotation.
+
+#include <stdio.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "api/video/i420_buffer.h"
+#include "api/video/video_frame.h"
+#include "strtc_video_frame_converter.h"
+#include "third_party/libyuv/include/libyuv/convert_argb.h"
+#include "third_party/libyuv/include/libyuv/rotate.h"
+#include "third_party/libyuv/include/libyuv/scale_argb.h"
+
+namespace {
+constexpr int kIterations = 200;
+
+struct Size {
+  int width;
+  int height;
+};
+
+rtc::scoped_refptr<webrtc::I420Buffer> CreateSource(int width, int height) {
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      webrtc::I420Buffer::Create(width, height);
+  // Gradients, so the scaler cannot take a flat-color shortcut.
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      buffer->MutableDataY()[y * buffer->StrideY() + x] =
+          static_cast<uint8_t>(x + y);
+    }
+  }
+  for (int y = 0; y < buffer->ChromaHeight(); ++y) {
+    for (int x = 0; x < buffer->ChromaWidth(); ++x) {
+      buffer->MutableDataU()[y * buffer->StrideU() + x] =
+          static_cast<uint8_t>(x);
+      buffer->MutableDataV()[y * buffer->StrideV() + x] =
+          static_cast<uint8_t>(y);
+    }
+  }
+  return buffer;
+}
+
+// The renderer before VideoFrameConverter.
+class LegacyConverter {
+ public:
+  void Convert(const webrtc::VideoFrame& frame, int target_width,
+               int target_height) {
+    rtc::scoped_refptr<webrtc::I420BufferInterface> i420 =
+        frame.video_frame_buffer()->ToI420();
+    if (frame.rotation() != webrtc::kVideoRotation_0) {
+      i420 = webrtc::I420Buffer::Rotate(*i420, frame.rotation());
+    }
+    int width = i420->width();
+    int height = i420->height();
+    full_.resize(static_cast<size_t>(width) * height * 4);
+    libyuv::I420ToARGB(i420->DataY(), i420->StrideY(), i420->DataU(),
+                       i420->StrideU(), i420->DataV(), i420->StrideV(),
+                       full_.data(), width * 4, width, height);
+
+    tile_.resize(static_cast<size_t>(target_width) * target_height * 4);
+    libyuv::ARGBScale(full_.data(), width * 4, width, height, tile_.data(),
+                      target_width * 4, target_width, target_height,
+                      libyuv::kFilterBox);
+  }
+
+ private:
+  std::vector<uint8_t> full_;
+  std::vector<uint8_t> tile_;
+};
+
+template <typename Function>
+double MeasureMs(Function function) {
+  // One warm-up call sizes the buffers and fills the pool.
+  function();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; ++i) {
+    function();
+  }
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / kIterations;
+}
+}  // namespace
+
+int main() {
+  const Size sources[] = {{640, 360}, {1280, 720}, {1920, 1080}, {3840, 2160}};
+  const Size tiles[] = {{320, 180}, {640, 360}, {1280, 720}};
+  const webrtc::VideoRotation rotations[] = {webrtc::kVideoRotation_0,
+                                             webrtc::kVideoRotation_90};
+
+  printf("%-11s %-10s %-4s %11s %11s %8s\n", "source", "tile", "rot",
+         "legacy(ms)", "fused(ms)", "speedup");
+  for (const Size& source : sources) {
+    rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+        CreateSource(source.width, source.height);
+    for (webrtc::VideoRotation rotation : rotations) {
+      webrtc::VideoFrame frame = webrtc::VideoFrame::Builder()
+                                     .set_video_frame_buffer(buffer)
+                                     .set_rotation(rotation)
+                                     .build();
+      for (const Size& tile : tiles) {
+        if (tile.width > source.width) {
+          continue;
+        }
+
+        LegacyConverter legacy;
+        double legacy_ms = MeasureMs(
+            [&]() { legacy.Convert(frame, tile.width, tile.height); });
+
+        strtc::VideoFrameConverter converter;
+        const uint8_t* argb = nullptr;
+        int stride = 0;
+        int width = 0;
+        int height = 0;
+        double fused_ms = MeasureMs([&]() {
+          converter.ConvertToARGB(frame, tile.width, tile.height, &argb,
+                                  &stride, &width, &height);
+        });
+
+        char source_name[16];
+        char tile_name[16];
+        snprintf(source_name, sizeof(source_name), "%dx%d", source.width,
+                 source.height);
+        snprintf(tile_name, sizeof(tile_name), "%dx%d", tile.width,
+                 tile.height);
+        printf("%-11s %-10s %-4d %11.3f %11.3f %7.1fx\n", source_name,
+               tile_name, static_cast<int>(rotation), legacy_ms, fused_ms,
+               legacy_ms / fused_ms);
+      }
+    }
+  }
+  return 0;
+}
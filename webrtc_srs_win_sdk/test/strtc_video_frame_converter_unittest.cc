@@ -0,0 +1,97 @@
+#include <stdint.h>
+
+#include "api/video/i420_buffer.h"
+#include "api/video/nv12_buffer.h"
+#include "api/video/video_frame.h"
+#include "strtc_test.h"
+#include "strtc_video_frame_converter.h"
+
+namespace {
+constexpr int kFrames = 20;
+// A 640x360 source rotated into a 160x160 tile: scaled to 160x90 first,
+// then rotated to 90x160.
+constexpr int kSourceWidth = 640;
+constexpr int kSourceHeight = 360;
+constexpr int kTileSize = 160;
+
+webrtc::VideoFrame Frame(rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer,
+                         webrtc::VideoRotation rotation) {
+  return webrtc::VideoFrame::Builder()
+      .set_video_frame_buffer(buffer)
+      .set_rotation(rotation)
+      .build();
+}
+
+// Converts kFrames frames and returns the allocations after the first and
+// after the last one.
+void ConvertFrames(strtc::VideoFrameConverter* converter,
+                   const webrtc::VideoFrame& frame, int64_t* first,
+                   int64_t* last) {
+  for (int i = 0; i < kFrames; ++i) {
+    const uint8_t* argb = nullptr;
+    int stride = 0;
+    int width = 0;
+    int height = 0;
+    STRTC_EXPECT(converter->ConvertToARGB(frame, kTileSize, kTileSize, &argb,
+                                          &stride, &width, &height));
+    STRTC_EXPECT(width == 90 && height == 160);
+    if (i == 0) {
+      *first = converter->allocations();
+    }
+  }
+  *last = converter->allocations();
+}
+}  // namespace
+
+STRTC_TEST(RotatedDownscaledI420AllocatesOnce) {
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      webrtc::I420Buffer::Create(kSourceWidth, kSourceHeight);
+  webrtc::I420Buffer::SetBlack(buffer.get());
+  strtc::VideoFrameConverter converter;
+  int64_t first = 0;
+  int64_t last = 0;
+  ConvertFrames(&converter, Frame(buffer, webrtc::kVideoRotation_90), &first,
+                &last);
+  // ARGB, scaled and rotated buffer.
+  STRTC_EXPECT(first == 3);
+  STRTC_EXPECT(last == first);
+}
+
+STRTC_TEST(RotatedDownscaledNV12AllocatesOnce) {
+  rtc::scoped_refptr<webrtc::NV12Buffer> buffer =
+      webrtc::NV12Buffer::Create(kSourceWidth, kSourceHeight);
+  strtc::VideoFrameConverter converter;
+  int64_t first = 0;
+  int64_t last = 0;
+  ConvertFrames(&converter, Frame(buffer, webrtc::kVideoRotation_270), &first,
+                &last);
+  STRTC_EXPECT(first == 3);
+  STRTC_EXPECT(last == first);
+}
+
+STRTC_TEST(AlternatingRotationKeepsBuffers) {
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      webrtc::I420Buffer::Create(kSourceWidth, kSourceHeight);
+  webrtc::I420Buffer::SetBlack(buffer.get());
+  strtc::VideoFrameConverter converter;
+  webrtc::VideoFrame rotated = Frame(buffer, webrtc::kVideoRotation_90);
+  webrtc::VideoFrame upright = Frame(buffer, webrtc::kVideoRotation_0);
+  const uint8_t* argb = nullptr;
+  int stride = 0;
+  int width = 0;
+  int height = 0;
+  converter.ConvertToARGB(rotated, kTileSize, kTileSize, &argb, &stride,
+                          &width, &height);
+  converter.ConvertToARGB(upright, kTileSize, kTileSize, &argb, &stride,
+                          &width, &height);
+  int64_t warm = converter.allocations();
+  for (int i = 0; i < kFrames; ++i) {
+    converter.ConvertToARGB(i % 2 ? upright : rotated, kTileSize, kTileSize,
+                            &argb, &stride, &width, &height);
+  }
+  STRTC_EXPECT(converter.allocations() == warm);
+}
+
+int main() {
+  return strtc::test::RunAll();
+}
@@ -0,0 +1,128 @@
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "api/video/i420_buffer.h"
+#include "api/video/video_frame.h"
+#include "rtc_base/time_utils.h"
+#include "strtc_test.h"
+#include "strtc_video_render_pipeline.h"
+#include "strtc_video_render_surface.h"
+
+namespace {
+constexpr int kTimeoutMs = 2000;
+
+webrtc::VideoFrame BlackFrame(int width, int height) {
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      webrtc::I420Buffer::Create(width, height);
+  webrtc::I420Buffer::SetBlack(buffer.get());
+  return webrtc::VideoFrame::Builder().set_video_frame_buffer(buffer).build();
+}
+
+// The pipeline owns its surface, the test keeps a pointer to look at it.
+struct Pipeline {
+  explicit Pipeline(int refresh_interval_ms)
+      : surface(new strtc::MemoryRenderSurface(refresh_interval_ms)),
+        pipeline(std::unique_ptr<strtc::VideoRenderSurface>(surface)) {}
+
+  strtc::MemoryRenderSurface* surface;
+  strtc::VideoRenderPipeline pipeline;
+};
+}  // namespace
+
+STRTC_TEST(LatestFrameWinsUnderBurst) {
+  Pipeline pipeline(100);
+  pipeline.pipeline.OnFrame(BlackFrame(16, 16));
+  STRTC_EXPECT(strtc::test::WaitFor(
+      [&]() { return pipeline.surface->presented() == 1; }, kTimeoutMs));
+
+  // Far quicker than the next refresh, only the last one is presented. The
+  // frames are told apart by their width, presented at their own size.
+  constexpr int kBurst = 10;
+  for (int i = 1; i <= kBurst; ++i) {
+    pipeline.pipeline.OnFrame(BlackFrame(16 + 2 * i, 16));
+  }
+  STRTC_EXPECT(strtc::test::WaitFor(
+      [&]() { return pipeline.surface->presented() == 2; }, kTimeoutMs));
+  std::vector<uint8_t> argb;
+  int width = 0;
+  int height = 0;
+  STRTC_EXPECT(pipeline.surface->GetImage(&argb, &width, &height));
+  STRTC_EXPECT(width == 16 + 2 * kBurst);
+
+  strtc::VideoRenderStats stats = pipeline.pipeline.GetStats();
+  STRTC_EXPECT(stats.received == kBurst + 1);
+  STRTC_EXPECT(stats.rendered == 2);
+  STRTC_EXPECT(stats.dropped == kBurst - 1);
+}
+
+STRTC_TEST(PresentsPacedToRefreshInterval) {
+  constexpr int kIntervalMs = 25;
+  constexpr int kDurationMs = 500;
+  Pipeline pipeline(kIntervalMs);
+  webrtc::VideoFrame frame = BlackFrame(32, 32);
+  int64_t end_ms = rtc::TimeMillis() + kDurationMs;
+  int frames = 0;
+  while (rtc::TimeMillis() < end_ms) {
+    pipeline.pipeline.OnFrame(frame);
+    ++frames;
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+
+  // One per interval, plus the first one and a late wakeup. The lower
+  // bound only rules out a stalled render thread.
+  int64_t presented = pipeline.surface->presented();
+  STRTC_EXPECT(presented <= kDurationMs / kIntervalMs + 2);
+  STRTC_EXPECT(presented >= kDurationMs / kIntervalMs / 2);
+  STRTC_EXPECT(frames > presented);
+}
+
+STRTC_TEST(WantsFollowSizeAndVisibility) {
+  constexpr int kIntervalMs = 20;
+  Pipeline pipeline(kIntervalMs);
+  std::mutex mutex;
+  rtc::VideoSinkWants last;
+  pipeline.pipeline.SetWantsCallback([&](const rtc::VideoSinkWants& wants) {
+    std::lock_guard<std::mutex> lock(mutex);
+    last = wants;
+  });
+  auto wants_are = [&](int pixels, int fps) {
+    return strtc::test::WaitFor(
+        [&]() {
+          std::lock_guard<std::mutex> lock(mutex);
+          return last.max_pixel_count == pixels &&
+                 last.max_framerate_fps == fps;
+        },
+        kTimeoutMs);
+  };
+
+  pipeline.surface->SetTargetSize(320, 180);
+  STRTC_EXPECT(wants_are(320 * 180, 1000 / kIntervalMs));
+  STRTC_EXPECT(pipeline.pipeline.GetWants().target_pixel_count ==
+               absl::optional<int>(320 * 180));
+
+  pipeline.surface->SetVisible(false);
+  STRTC_EXPECT(wants_are(320 * 180, 0));
+  // Frames still arriving while hidden are taken but not presented.
+  int64_t presented = pipeline.surface->presented();
+  for (int i = 0; i < 10; ++i) {
+    pipeline.pipeline.OnFrame(BlackFrame(32, 32));
+    std::this_thread::sleep_for(std::chrono::milliseconds(kIntervalMs));
+  }
+  STRTC_EXPECT(pipeline.surface->presented() == presented);
+
+  pipeline.surface->SetVisible(true);
+  STRTC_EXPECT(wants_are(320 * 180, 1000 / kIntervalMs));
+  STRTC_EXPECT(strtc::test::WaitFor(
+      [&]() {
+        pipeline.pipeline.OnFrame(BlackFrame(32, 32));
+        return pipeline.surface->presented() > presented;
+      },
+      kTimeoutMs));
+  pipeline.pipeline.SetWantsCallback(nullptr);
+}
+
+int main() {
+  return strtc::test::RunAll();
+}